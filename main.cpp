@@ -2,42 +2,39 @@
 #include <vector>
 #include <algorithm>
 #include <memory>
+#include <chrono>
+#include <stdexcept>
 #include "resc/seller.h"
 #include "resc/bank_customer.h"
 #include "resc/buyer.h"
 #include "resc/transaction.h"
 #include "resc/datetime.h"
 #include "resc/persistence.h"
+#include "resc/journal.h"
+#include "resc/market.h"
+#include "resc/catalog_query.h"
+#include "resc/catalog_io.h"
 
 enum PrimaryPrompt { LOGIN, REGISTER, EXIT_MAIN };
 
 using namespace std;
 
-void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& pendingOrders, 
-                   vector<Transaction>& transactions, vector<Buyer>& buyers, 
-                   vector<unique_ptr<BankCustomer>>& bankAccounts, int& sellerIdCounter);
-void showSellerMenu(seller* sellerAccount, vector<seller>& sellers, vector<Transaction>& transactions, 
-                    vector<Transaction>& pendingOrders, vector<Buyer>& buyers,
-                    vector<unique_ptr<BankCustomer>>& bankAccounts);
+void showBuyerMenu(BuyerHandle self, AppState& state, store::Journal& journal);
+void showSellerMenu(SellerHandle self, AppState& state, store::Journal& journal);
 
 int main() {
-    vector<Buyer> buyers;
-    vector<unique_ptr<BankCustomer>> bankAccounts;
-    vector<Transaction> transactions;
-    vector<Transaction> pendingOrders;
-    vector<seller> sellers;
-
     AppState state;
-    store::load_all(state, "database");
-    buyers = state.buyers;
-    sellers = state.sellers;
-    bankAccounts.clear();
-    for (auto &acc : state.bankAccounts) bankAccounts.push_back(move(acc));
-    transactions = state.transactions;
-    pendingOrders = state.pendingOrders;
-
-    int buyerIdCounter = buyers.empty() ? 1 : (buyers.back().getId() + 1);
-    int sellerIdCounter = sellers.empty() ? 1 : (sellers.back().getSellerId() + 1);
+    if (store::load_all(state, "database") == store::LoadResult::CORRUPT) {
+        cout << "[X] database/" << store::SNAPSHOT_FILE << " is damaged; restore it from a backup before starting." << endl;
+        return 1;
+    }
+    store::Journal journal("database");
+    // Disk writes happen on the journal worker; commits within 5ms share one fsync
+    journal.startBackground(chrono::milliseconds(5), store::Durability::FSYNC);
+    // Unpaid orders stop holding stock after a few days
+    if (size_t expired = market::expireOrders(state, journal, market::ORDER_HOLD_DAYS)) {
+        cout << "[i] " << expired << " unpaid order(s) expired, their stock is available again." << endl;
+    }
 
     PrimaryPrompt prompt = LOGIN;
     while (prompt != EXIT_MAIN) {
@@ -65,30 +62,18 @@ int main() {
                 cout << "Enter your Name: ";
                 getline(cin, loginName);
 
-                // Check if user is a SELLER
-                auto sellerIt = find_if(sellers.begin(), sellers.end(),
-                    [loginId, &loginName](const seller &s) {
-                        return s.getId() == loginId && s.getName() == loginName;
-                    });
-
-                if (sellerIt != sellers.end()) {
-                    // LOGIN AS SELLER
-                    cout << "\n--- Login successful! Welcome, " << sellerIt->getName() << " (SELLER) ---" << endl;
-                    cout << "Store: " << sellerIt->getStoreName() << endl;
-                    showSellerMenu(&(*sellerIt), sellers, transactions, pendingOrders, buyers, bankAccounts);
-                    continue;
-                }
-
-                // Check if user is a BUYER
-                auto buyerIt = find_if(buyers.begin(), buyers.end(),
-                    [loginId, &loginName](const Buyer &b) {
-                        return b.getId() == loginId && b.getName() == loginName;
-                    });
-
-                if (buyerIt != buyers.end()) {
+                Buyer* buyerIt = state.findBuyer(loginId);
+                if (buyerIt && buyerIt->getName() == loginName) {
+                    // Users with a storefront get the seller menu
+                    if (const seller* sellerIt = state.findSellerByBuyer(loginId)) {
+                        cout << "\n--- Login successful! Welcome, " << buyerIt->getName() << " (SELLER) ---" << endl;
+                        cout << "Store: " << sellerIt->getStoreName() << endl;
+                        showSellerMenu(state.sellerHandleByBuyer(loginId), state, journal);
+                        continue;
+                    }
                     // LOGIN AS BUYER
                     cout << "\n--- Login successful! Welcome, " << buyerIt->getName() << " (BUYER) ---" << endl;
-                    showBuyerMenu(&(*buyerIt), sellers, pendingOrders, transactions, buyers, bankAccounts, sellerIdCounter);
+                    showBuyerMenu(state.buyerHandle(loginId), state, journal);
                     continue;
                 }
 
@@ -130,16 +115,8 @@ int main() {
                 cout << "Enter Address: ";
                 getline(cin, address);
                 
-                int newBuyerId = buyerIdCounter++;
-                buyers.emplace_back(newBuyerId, name, email, phone, address, nullptr);
-                // Save after mutation
-                AppState state;
-                state.buyers = buyers;
-                state.sellers = sellers;
-                for (auto &acc : bankAccounts) state.bankAccounts.push_back(make_unique<BankCustomer>(*acc));
-                state.transactions = transactions;
-                state.pendingOrders = pendingOrders;
-                store::save_all(state, "database");
+                int newBuyerId = 0;
+                market::registerBuyer(state, journal, name, email, phone, address, newBuyerId);
                 cout << "\n--- Buyer registered successfully! ---" << endl;
                 cout << "Your ID: " << newBuyerId << endl;
                 cout << "Name: " << name << endl;
@@ -157,6 +134,8 @@ int main() {
         }
     }
 
+    // Make sure everything the session committed reached the disk
+    journal.flush();
     return 0;
 }
 
@@ -164,12 +143,23 @@ int main() {
 // ========================================
 // BUYER MENU
 // ========================================
-void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& pendingOrders, 
-                   vector<Transaction>& transactions, vector<Buyer>& buyers, 
-                   vector<unique_ptr<BankCustomer>>& bankAccounts, int& sellerIdCounter) {
+// Stores by seller id, so menu numbers do not depend on storage order.
+static vector<const seller*> storeList(const AppState& state) {
+    vector<const seller*> stores;
+    stores.reserve(state.sellers.size());
+    for (const auto& s : state.sellers) stores.push_back(&s);
+    sort(stores.begin(), stores.end(), [](const seller* a, const seller* b) { return a->getSellerId() < b->getSellerId(); });
+    return stores;
+}
+
+void showBuyerMenu(BuyerHandle self, AppState& state, store::Journal& journal) {
     bool logout = false;
     
     while (!logout) {
+        // Looked up each time round: the handle stops resolving if the user is gone
+        Buyer* buyer = state.buyers.get(self);
+        if (!buyer) return;
+        vector<const seller*> sellers = storeList(state);
         cout << "\n========================================" << endl;
         cout << "   BUYER MENU - " << buyer->getName() << endl;
         cout << "========================================" << endl;
@@ -181,7 +171,9 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
         cout << "6. Payment (Complete Pending Orders)" << endl;
         cout << "7. Upgrade to Seller" << endl;
         cout << "8. Delete Account" << endl;
-        cout << "9. Logout" << endl;
+        cout << "9. Find Items by Price" << endl;
+        cout << "10. Search Items" << endl;
+        cout << "11. Logout" << endl;
         cout << "Select option: ";
         
         int choice;
@@ -197,9 +189,9 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
                 cout << "Address: " << buyer->getAddress() << endl;
                 cout << "Role: BUYER" << endl;
 
-                if (buyer->getAccount() && buyer->getAccount()->getId() != 0) {
+                if (state.accountOf(*buyer) && state.accountOf(*buyer)->getId() != 0) {
                     cout << "\n--- Bank Account ---" << endl;
-                    buyer->getAccount()->printInfo();
+                    state.accountOf(*buyer)->printInfo();
                 } else {
                     cout << "\n--- Bank Account ---" << endl;
                     cout << "[X] No bank account linked." << endl;
@@ -209,78 +201,63 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
 
             case 2: { // Create Bank Account
                 cout << "\n=== CREATE BANK ACCOUNT ===" << endl;
-                if (buyer->getAccount() && buyer->getAccount()->getId() != 0) {
+                if (state.accountOf(*buyer) && state.accountOf(*buyer)->getId() != 0) {
                     cout << "[X] You already have a bank account!" << endl;
-                    buyer->getAccount()->printInfo();
+                    state.accountOf(*buyer)->printInfo();
                     break;
                 }
                 
-                double deposit;
+                Money deposit;
                 cout << "Enter initial deposit: $";
                 cin >> deposit;
                 
                 // Warn if creating dormant account
-                if (deposit <= 0) {
+                if (deposit <= Money()) {
                     cout << "\n⚠️  WARNING: Creating account with $0 balance." << endl;
                     cout << "    Your account will be DORMANT until you deposit money." << endl;
                 }
                 
-                auto newBank = make_unique<BankCustomer>(buyer->getId(), buyer->getName(), deposit);
-                bankAccounts.push_back(move(newBank));
-                for (auto& b : buyers) {
-                    if (b.getId() == buyer->getId()) {
-                        b.setAccount(bankAccounts.back().get());
-                        buyer = &b;
-                        break;
-                    }
-                }
-                // Save after mutation
-                AppState state;
-                state.buyers = buyers;
-                state.sellers = sellers;
-                for (auto &acc : bankAccounts) state.bankAccounts.push_back(make_unique<BankCustomer>(*acc));
-                state.transactions = transactions;
-                state.pendingOrders = pendingOrders;
-                store::save_all(state, "database");
+                market::openAccount(state, journal, buyer->getId(), deposit);
                 cout << "\n--- Bank account created successfully! ---" << endl;
-                buyer->getAccount()->printInfo();
+                state.accountOf(*buyer)->printInfo();
                 break;
             }
 
             case 3: { // Top Up Balance
                 cout << "\n=== TOP UP BALANCE ===" << endl;
-                if (!buyer->getAccount() || buyer->getAccount()->getId() == 0) {
+                if (!state.accountOf(*buyer) || state.accountOf(*buyer)->getId() == 0) {
                     cout << "[X] You don't have a bank account! Create one first." << endl;
                     break;
                 }
                 
-                cout << "Current balance: $" << buyer->getAccount()->getBalance() << endl;
-                if (buyer->getAccount()->isDormant()) {
+                cout << "Current balance: $" << state.accountOf(*buyer)->getBalance() << endl;
+                if (state.accountOf(*buyer)->isDormant()) {
                     cout << "⚠️  Your account is DORMANT. Please deposit to reactivate." << endl;
                 }
                 
-                double topUpAmount;
+                Money topUpAmount;
                 cout << "\nEnter amount to deposit: $";
                 cin >> topUpAmount;
                 
-                if (topUpAmount <= 0) {
+                if (topUpAmount <= Money()) {
                     cout << "[X] Invalid amount! Must be greater than 0." << endl;
                     break;
                 }
                 
-                buyer->getAccount()->addBalance(topUpAmount);
-                
-                // Save after mutation
-                AppState state;
-                state.buyers = buyers;
-                state.sellers = sellers;
-                for (auto &acc : bankAccounts) state.bankAccounts.push_back(make_unique<BankCustomer>(*acc));
-                state.transactions = transactions;
-                state.pendingOrders = pendingOrders;
-                store::save_all(state, "database");
+                bool wasDormant = state.accountOf(*buyer)->isDormant();
+                market::Status deposited = market::topUp(state, journal, buyer->getId(), topUpAmount);
+                if (deposited != market::OK) {
+                    cout << "[X] Deposit failed: " << market::statusName(deposited) << endl;
+                    break;
+                }
                 
                 cout << "\n--- Deposit successful! ---" << endl;
-                cout << "New balance: $" << buyer->getAccount()->getBalance() << endl;
+                cout << "New balance: $" << state.accountOf(*buyer)->getBalance() << endl;
+                // Show reactivation message if account was dormant
+                if (wasDormant && !state.accountOf(*buyer)->isDormant()) {
+                    cout << "\nACCOUNT REACTIVATED!" << endl;
+                    cout << "   Your account is now active with balance: $" << state.accountOf(*buyer)->getBalance() << endl;
+                }
                 break;
             }
 
@@ -293,8 +270,8 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
                 
                 cout << "\nAvailable Sellers:" << endl;
                 for (size_t i = 0; i < sellers.size(); i++) {
-                    cout << (i + 1) << ". " << sellers[i].getStoreName() 
-                         << " (Seller ID: " << sellers[i].getSellerId() << ")" << endl;
+                    cout << (i + 1) << ". " << sellers[i]->getStoreName() 
+                         << " (Seller ID: " << sellers[i]->getSellerId() << ")" << endl;
                 }
                 
                 cout << "\nEnter seller number (0 to cancel): ";
@@ -302,8 +279,8 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
                 cin >> sellerChoice;
                 
                 if (sellerChoice > 0 && sellerChoice <= static_cast<int>(sellers.size())) {
-                    const seller& chosenSeller = sellers[sellerChoice - 1];
-                    const auto& items = chosenSeller.getItems();
+                    const seller& chosenSeller = *sellers[sellerChoice - 1];
+                    ItemRange items = state.items(chosenSeller.getSellerId());
                     
                     cout << "\n=== " << chosenSeller.getStoreName() << " Inventory ===" << endl;
                     if (items.empty()) {
@@ -331,7 +308,7 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
                 
                 cout << "\nAvailable Sellers:" << endl;
                 for (size_t i = 0; i < sellers.size(); i++) {
-                    cout << (i + 1) << ". " << sellers[i].getStoreName() << endl;
+                    cout << (i + 1) << ". " << sellers[i]->getStoreName() << endl;
                 }
                 
                 cout << "\nSelect seller (0 to cancel): ";
@@ -343,8 +320,8 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
                     break;
                 }
                 
-                seller& chosenSeller = sellers[selChoice - 1];
-                const auto& items = chosenSeller.getItems();
+                const seller& chosenSeller = *sellers[selChoice - 1];
+                ItemRange items = state.items(chosenSeller.getSellerId());
                 
                 if (items.empty()) {
                     cout << "[X] This store has no items." << endl;
@@ -361,9 +338,7 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
                          << item.getPrice() << endl;
                 }
                 
-                string today = dt::today();  // Automatically gets today's date from system
-                Transaction newOrder(buyer->getId(), buyer->getName(),
-                                   chosenSeller.getSellerId(), chosenSeller.getStoreName(), today);
+                vector<market::OrderLine> orderLines;
                 
                 char addMore = 'y';
                 while (addMore == 'y' || addMore == 'Y') {
@@ -371,21 +346,27 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
                     cout << "\nEnter Item ID: ";
                     cin >> itemId;
                     
-                    auto& mutableItems = chosenSeller.getItems();
-                    auto itemIt = find_if(mutableItems.begin(), mutableItems.end(),
-                        [itemId](const Item& i) { return i.getId() == itemId; });
+                    Item itemIt = state.findItem(chosenSeller.getSellerId(), itemId);
                     
-                    if (itemIt == mutableItems.end()) {
+                    if (!itemIt) {
                         cout << "[X] Item not found!" << endl;
                     } else {
                         cout << "Enter quantity: ";
                         cin >> qty;
                         
-                        if (qty > itemIt->getQuantity()) {
-                            cout << "[X] Not enough stock! Available: " << itemIt->getQuantity() << endl;
+                        // Stock already claimed by earlier lines of this order
+                        int claimed = 0;
+                        for (const auto& line : orderLines) {
+                            if (line.itemId == itemId) claimed += line.quantity;
+                        }
+                        int available = itemIt.getQuantity() - claimed;
+                        
+                        if (qty <= 0) {
+                            cout << "[X] Quantity must be greater than 0." << endl;
+                        } else if (qty > available) {
+                            cout << "[X] Not enough stock! Available: " << available << endl;
                         } else {
-                            newOrder.addItem(itemIt->getId(), itemIt->getName(), qty, itemIt->getPrice());
-                            itemIt->setQuantity(itemIt->getQuantity() - qty);
+                            orderLines.push_back({itemId, qty});
                             cout << "--- Added to order! ---" << endl;
                         }
                     }
@@ -394,29 +375,21 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
                     cin >> addMore;
                 }
                 
-                if (newOrder.getItems().empty()) {
+                int orderId = 0;
+                if (orderLines.empty()) {
                     cout << "No items ordered." << endl;
-                } else {
-                    pendingOrders.push_back(newOrder);
+                } else if (market::placeOrder(state, journal, buyer->getId(), chosenSeller.getSellerId(), orderLines, orderId) == market::OK) {
                     cout << "\n--- Order created! Go to Payment to complete. ---" << endl;
-                    newOrder.printTransactionDetails();
+                    if (auto created = market::findPendingOrder(state, orderId)) created->printTransactionDetails();
+                } else {
+                    cout << "[X] Order could not be placed." << endl;
                 }
                 break;
             }
 
             case 6: { // Payment
                 cout << "\n=== PAYMENT ===" << endl;
-                if (pendingOrders.empty()) {
-                    cout << "[X] No pending orders." << endl;
-                    break;
-                }
-                
-                vector<Transaction*> buyerOrders;
-                for (auto& order : pendingOrders) {
-                    if (order.getBuyerId() == buyer->getId()) {
-                        buyerOrders.push_back(&order);
-                    }
-                }
+                vector<Transaction> buyerOrders = market::pendingOrdersForBuyer(state, buyer->getId()).orders;
                 
                 if (buyerOrders.empty()) {
                     cout << "[X] You have no pending orders." << endl;
@@ -425,9 +398,9 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
                 
                 cout << "\nYour Pending Orders:" << endl;
                 for (size_t i = 0; i < buyerOrders.size(); i++) {
-                    cout << (i + 1) << ". Transaction #" << buyerOrders[i]->getTransactionId()
-                         << " - $" << buyerOrders[i]->getTotalAmount()
-                         << " to " << buyerOrders[i]->getSellerName() << endl;
+                    cout << (i + 1) << ". Transaction #" << buyerOrders[i].getTransactionId()
+                         << " - $" << buyerOrders[i].getTotalAmount()
+                         << " to " << buyerOrders[i].getSellerName() << endl;
                 }
                 
                 cout << "\nSelect order to pay (0 to cancel): ";
@@ -439,68 +412,51 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
                     break;
                 }
                 
-                Transaction* orderToPay = buyerOrders[orderChoice - 1];
+                const Transaction* orderToPay = &buyerOrders[orderChoice - 1];
                 
-                if (!buyer->getAccount() || buyer->getAccount()->getId() == 0) {
+                if (!state.accountOf(*buyer) || state.accountOf(*buyer)->getId() == 0) {
                     cout << "[X] You don't have a bank account! Create one first." << endl;
                     break;
                 }
                 
                 // Check if account is dormant
-                if (buyer->getAccount()->isDormant()) {
+                if (state.accountOf(*buyer)->isDormant()) {
                     cout << "\n❌ PAYMENT BLOCKED: Your account is DORMANT!" << endl;
-                    cout << "   Current balance: $" << buyer->getAccount()->getBalance() << endl;
+                    cout << "   Current balance: $" << state.accountOf(*buyer)->getBalance() << endl;
                     cout << "   Please deposit money first to reactivate your account." << endl;
                     cout << "\n   💡 Tip: Use 'Account Status' to see your account details." << endl;
                     break;
                 }
                 
-                if (buyer->getAccount()->getBalance() < orderToPay->getTotalAmount()) {
+                if (state.accountOf(*buyer)->getBalance() < orderToPay->getTotalAmount()) {
                     cout << "[X] Insufficient balance! You have $" 
-                         << buyer->getAccount()->getBalance()
+                         << state.accountOf(*buyer)->getBalance()
                          << " but need $" << orderToPay->getTotalAmount() << endl;
                     break;
                 }
                 
                 cout << "\n=== Payment Confirmation ===" << endl;
                 orderToPay->printTransactionDetails();
-                cout << "\nYour current balance: $" << buyer->getAccount()->getBalance() << endl;
-                cout << "Confirm payment? (y/n): ";
+                cout << "\nYour current balance: $" << state.accountOf(*buyer)->getBalance() << endl;
+                cout << "Confirm payment? (y/n, c = cancel order): ";
                 char confirm;
                 cin >> confirm;
                 
                 if (confirm == 'y' || confirm == 'Y') {
-                    buyer->getAccount()->withdrawBalance(orderToPay->getTotalAmount());
-                    
-                    auto sellerIt = find_if(sellers.begin(), sellers.end(),
-                        [orderToPay](const seller& s) { 
-                            return s.getSellerId() == orderToPay->getSellerId(); 
-                        });
-                    
-                    if (sellerIt != sellers.end() && sellerIt->getAccount()) {
-                        sellerIt->getAccount()->addBalance(orderToPay->getTotalAmount());
+                    Money newBalance;
+                    market::Status paid = market::payOrder(state, journal, buyer->getId(), orderToPay->getTransactionId(), newBalance);
+                    if (paid == market::OK) {
+                        cout << "\n--- Payment successful! ---" << endl;
+                        cout << "New balance: $" << newBalance << endl;
+                    } else {
+                        cout << "[X] Payment failed: " << market::statusName(paid) << endl;
+                    }
+                } else if (confirm == 'c' || confirm == 'C') {
+                    if (market::cancelOrder(state, journal, buyer->getId(), orderToPay->getTransactionId()) == market::OK) {
+                        cout << "\n--- Order cancelled, its items are back in stock. ---" << endl;
+                    } else {
+                        cout << "[X] Order could not be cancelled." << endl;
                     }
-                    
-                    orderToPay->setStatus(PAID);
-                    transactions.push_back(*orderToPay);
-                    
-                    pendingOrders.erase(remove_if(pendingOrders.begin(), pendingOrders.end(),
-                        [orderToPay](const Transaction& t) {
-                            return t.getTransactionId() == orderToPay->getTransactionId();
-                        }), pendingOrders.end());
-                    
-                    cout << "\n--- Payment successful! ---" << endl;
-                    cout << "New balance: $" << buyer->getAccount()->getBalance() << endl;
-                    
-                    // Save all data after payment
-                    AppState tempState;
-                    tempState.buyers = buyers;
-                    tempState.sellers = sellers;
-                    tempState.bankAccounts = move(bankAccounts);
-                    tempState.transactions = transactions;
-                    tempState.pendingOrders = pendingOrders;
-                    store::save_all(tempState, "database");
-                    bankAccounts = move(tempState.bankAccounts);
                 } else {
                     cout << "Payment cancelled." << endl;
                 }
@@ -511,16 +467,13 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
                 cout << "\n=== UPGRADE TO SELLER ===" << endl;
                 
                 // Check if already seller
-                auto checkSeller = find_if(sellers.begin(), sellers.end(),
-                    [buyer](const seller& s) { return s.getId() == buyer->getId(); });
-                
-                if (checkSeller != sellers.end()) {
+                if (state.findSellerByBuyer(buyer->getId())) {
                     cout << "[X] You are already a seller!" << endl;
                     cout << "Please logout and login again to access seller features." << endl;
                     break;
                 }
                 
-                if (!buyer->getAccount() || buyer->getAccount()->getId() == 0) {
+                if (!state.accountOf(*buyer) || state.accountOf(*buyer)->getId() == 0) {
                     cout << "[X] Cannot upgrade! You need a bank account first." << endl;
                     break;
                 }
@@ -530,16 +483,8 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
                 cout << "Enter Store Name: ";
                 getline(cin, storeName);
                 
-                int newSellerId = sellerIdCounter++;
-                sellers.emplace_back(*buyer, newSellerId, storeName);
-                // Save after mutation
-                AppState state;
-                state.buyers = buyers;
-                state.sellers = sellers;
-                for (auto &acc : bankAccounts) state.bankAccounts.push_back(make_unique<BankCustomer>(*acc));
-                state.transactions = transactions;
-                state.pendingOrders = pendingOrders;
-                store::save_all(state, "database");
+                int newSellerId = 0;
+                market::upgradeToSeller(state, journal, buyer->getId(), storeName, newSellerId);
                 cout << "\n--- Successfully upgraded to Seller! ---" << endl;
                 cout << "Seller ID: " << newSellerId << endl;
                 cout << "Store Name: " << storeName << endl;
@@ -554,13 +499,7 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
                 cin >> confirm;
                 
                 if (confirm == 'y' || confirm == 'Y') {
-                    int delId = buyer->getId();
-                    buyers.erase(remove_if(buyers.begin(), buyers.end(),
-                        [delId](const Buyer& b) { return b.getId() == delId; }), buyers.end());
-                    sellers.erase(remove_if(sellers.begin(), sellers.end(),
-                        [delId](const seller& s) { return s.getId() == delId; }), sellers.end());
-                    bankAccounts.erase(remove_if(bankAccounts.begin(), bankAccounts.end(),
-                        [delId](const unique_ptr<BankCustomer>& acc) { return acc->getId() == delId; }), bankAccounts.end());
+                    market::deleteUser(state, journal, buyer->getId());
                     cout << "\n--- Account deleted. ---" << endl;
                     logout = true;
                 } else {
@@ -569,7 +508,67 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
                 break;
             }
 
-            case 9: { // Logout
+            case 9: { // Find Items by Price
+                cout << "\n=== FIND ITEMS BY PRICE ===" << endl;
+                Money maxPrice;
+                cout << "Maximum price: $";
+                cin >> maxPrice;
+
+                // Every store at once, in stock only
+                query::ItemFilter filter;
+                filter.maxPrice = maxPrice;
+                filter.minQuantity = 1;
+                query::Selection rows = query::select(state.catalog, filter);
+                if (rows.empty()) {
+                    cout << "[X] No items in stock at or under $" << maxPrice << "." << endl;
+                    break;
+                }
+                cout << "Store\t\tID\tName\t\tQuantity\tPrice" << endl;
+                cout << "----------------------------------------------------------------" << endl;
+                for (uint32_t row : rows) {
+                    const seller* store = state.findSeller(state.catalog.sellerId(row));
+                    cout << (store ? store->getStoreName() : "?") << "\t\t"
+                         << state.catalog.itemId(row) << "\t"
+                         << state.catalog.name(row) << "\t\t"
+                         << state.catalog.quantity(row) << "\t\t$"
+                         << state.catalog.price(row) << endl;
+                }
+                cout << rows.size() << " item(s) found." << endl;
+                break;
+            }
+
+            case 10: { // Search Items
+                cout << "\n=== SEARCH ITEMS ===" << endl;
+                cout << "Search for: ";
+                string text;
+                cin.ignore();
+                getline(cin, text);
+
+                SearchResult found = state.search.search(text);
+                if (found.hits.empty()) {
+                    cout << "[X] No items match \"" << text << "\"." << endl;
+                    break;
+                }
+                cout << "Store\t\tID\tName\t\tQuantity\tPrice" << endl;
+                cout << "----------------------------------------------------------------" << endl;
+                for (const SearchHit& hit : found.hits) {
+                    Item item = state.findItem(hit.sellerId, hit.itemId);
+                    const seller* store = state.findSeller(hit.sellerId);
+                    if (!item || !store) continue;
+                    cout << store->getStoreName() << "\t\t"
+                         << item.getId() << "\t"
+                         << item.getName() << "\t\t"
+                         << item.getQuantity() << "\t\t$"
+                         << item.getPrice() << endl;
+                }
+                if (found.truncated) {
+                    cout << "⚠️  More items match than are shown; type more of the name to narrow it down." << endl;
+                }
+                cout << "Order from the store with option 5 using the item ID." << endl;
+                break;
+            }
+
+            case 11: { // Logout
                 cout << "\n--- Logged out successfully. ---" << endl;
                 logout = true;
                 break;
@@ -586,12 +585,13 @@ void showBuyerMenu(Buyer* buyer, vector<seller>& sellers, vector<Transaction>& p
 // ========================================
 // SELLER MENU
 // ========================================
-void showSellerMenu(seller* sellerAccount, vector<seller>& sellers, vector<Transaction>& transactions, 
-                    vector<Transaction>& pendingOrders, vector<Buyer>& buyers,
-                    vector<unique_ptr<BankCustomer>>& bankAccounts) {
+void showSellerMenu(SellerHandle self, AppState& state, store::Journal& journal) {
     bool logout = false;
     
     while (!logout) {
+        seller* sellerAccount = state.sellers.get(self);
+        Buyer* owner = sellerAccount ? state.ownerOf(*sellerAccount) : nullptr;
+        if (!owner) return;
         cout << "\n========================================" << endl;
         cout << "   SELLER MENU - " << sellerAccount->getStoreName() << endl;
         cout << "========================================" << endl;
@@ -600,8 +600,11 @@ void showSellerMenu(seller* sellerAccount, vector<seller>& sellers, vector<Trans
         cout << "3. Add Item to Inventory" << endl;
         cout << "4. Remove Item from Inventory" << endl;
         cout << "5. View All Orders" << endl;
-        cout << "6. Delete Account" << endl;
-        cout << "7. Logout" << endl;
+        cout << "6. Sales Report" << endl;
+        cout << "7. Delete Account" << endl;
+        cout << "8. Import Items (CSV/NDJSON)" << endl;
+        cout << "9. Export Items" << endl;
+        cout << "10. Logout" << endl;
         cout << "Select option: ";
         
         int choice;
@@ -610,19 +613,19 @@ void showSellerMenu(seller* sellerAccount, vector<seller>& sellers, vector<Trans
         switch (choice) {
             case 1: { // Account Status
                 cout << "\n=== ACCOUNT STATUS ===" << endl;
-                cout << "Buyer ID: " << sellerAccount->getId() << endl;
+                cout << "Buyer ID: " << owner->getId() << endl;
                 cout << "Seller ID: " << sellerAccount->getSellerId() << endl;
-                cout << "Name: " << sellerAccount->getName() << endl;
-                cout << "Email: " << sellerAccount->getEmail() << endl;
-                cout << "Phone: " << sellerAccount->getPhone() << endl;
-                cout << "Address: " << sellerAccount->getAddress() << endl;
+                cout << "Name: " << owner->getName() << endl;
+                cout << "Email: " << owner->getEmail() << endl;
+                cout << "Phone: " << owner->getPhone() << endl;
+                cout << "Address: " << owner->getAddress() << endl;
                 cout << "Role: SELLER" << endl;
                 cout << "Store Name: " << sellerAccount->getStoreName() << endl;
-                cout << "Inventory Items: " << sellerAccount->getItems().size() << endl;
+                cout << "Inventory Items: " << state.items(sellerAccount->getSellerId()).size() << endl;
 
-                if (sellerAccount->getAccount() && sellerAccount->getAccount()->getId() != 0) {
+                if (state.accountOf(*owner) && state.accountOf(*owner)->getId() != 0) {
                     cout << "\n--- Bank Account ---" << endl;
-                    sellerAccount->getAccount()->printInfo();
+                    state.accountOf(*owner)->printInfo();
                 } else {
                     cout << "\n--- Bank Account ---" << endl;
                     cout << "[X] No bank account linked." << endl;
@@ -632,18 +635,25 @@ void showSellerMenu(seller* sellerAccount, vector<seller>& sellers, vector<Trans
 
             case 2: { // Check Inventory
                 cout << "\n=== INVENTORY ===" << endl;
-                const auto& items = sellerAccount->getItems();
+                ItemRange items = state.items(sellerAccount->getSellerId());
                 if (items.empty()) {
                     cout << "[X] No items in inventory." << endl;
                 } else {
-                    cout << "ID\tName\t\tQuantity\tPrice" << endl;
-                    cout << "------------------------------------------------" << endl;
+                    cout << "ID\tName\t\tQuantity\tReserved\tPrice" << endl;
+                    cout << "----------------------------------------------------------------" << endl;
                     for (const auto& item : items) {
                         cout << item.getId() << "\t" 
                              << item.getName() << "\t\t" 
-                             << item.getQuantity() << "\t\t$" 
+                             << item.getQuantity() << "\t\t"
+                             << item.getReserved() << "\t\t$"
                              << item.getPrice() << endl;
                     }
+                    try {
+                        cout << "\nValue of available stock: $"
+                             << state.catalog.stockValue(state.catalog.rangeOf(sellerAccount->getSellerId())) << endl;
+                    } catch (const overflow_error&) {
+                        cout << "\nValue of available stock: too large to show" << endl;
+                    }
                 }
                 break;
             }
@@ -652,7 +662,7 @@ void showSellerMenu(seller* sellerAccount, vector<seller>& sellers, vector<Trans
                 cout << "\n=== ADD ITEM ===" << endl;
                 int id, qty;
                 string name;
-                double price;
+                Money price;
                 
                 cout << "Item ID: ";
                 cin >> id;
@@ -664,23 +674,20 @@ void showSellerMenu(seller* sellerAccount, vector<seller>& sellers, vector<Trans
                 cout << "Price: $";
                 cin >> price;
                 
-                sellerAccount->addNewItem(id, name, qty, price);
-                cout << "\n--- Item added to inventory! ---" << endl;
-                
-                // Save all data
-                AppState tempState;
-                tempState.buyers = buyers;
-                tempState.sellers = sellers;
-                tempState.bankAccounts = move(bankAccounts);
-                tempState.transactions = transactions;
-                store::save_all(tempState, "database");
-                bankAccounts = move(tempState.bankAccounts);
+                market::Status added = market::addItem(state, journal, sellerAccount->getSellerId(), id, name, qty, price);
+                if (added == market::OK) {
+                    cout << "\n--- Item added to inventory! ---" << endl;
+                } else if (added == market::ALREADY_EXISTS) {
+                    cout << "\n[X] An item with ID " << id << " already exists!" << endl;
+                } else {
+                    cout << "\n[X] Quantity and price cannot be negative!" << endl;
+                }
                 break;
             }
 
             case 4: { // Remove Item
                 cout << "\n=== REMOVE ITEM ===" << endl;
-                const auto& items = sellerAccount->getItems();
+                ItemRange items = state.items(sellerAccount->getSellerId());
                 
                 if (items.empty()) {
                     cout << "[X] No items in inventory." << endl;
@@ -696,22 +703,8 @@ void showSellerMenu(seller* sellerAccount, vector<seller>& sellers, vector<Trans
                 cout << "\nEnter Item ID to remove: ";
                 cin >> id;
                 
-                auto& mutableItems = sellerAccount->getItems();
-                auto it = find_if(mutableItems.begin(), mutableItems.end(),
-                    [id](const Item& i) { return i.getId() == id; });
-                
-                if (it != mutableItems.end()) {
-                    mutableItems.erase(it);
+                if (market::removeItem(state, journal, sellerAccount->getSellerId(), id) == market::OK) {
                     cout << "\n--- Item removed! ---" << endl;
-                    
-                    // Save all data
-                    AppState tempState;
-                    tempState.buyers = buyers;
-                    tempState.sellers = sellers;
-                    tempState.bankAccounts = move(bankAccounts);
-                    tempState.transactions = transactions;
-                    store::save_all(tempState, "database");
-                    bankAccounts = move(tempState.bankAccounts);
                 } else {
                     cout << "\n[X] Item not found!" << endl;
                 }
@@ -721,44 +714,67 @@ void showSellerMenu(seller* sellerAccount, vector<seller>& sellers, vector<Trans
             case 5: { // View Orders
                 cout << "\n=== ALL ORDERS ===" << endl;
                 
-                vector<Transaction*> sellerTransactions;
-                for (auto& t : transactions) {
-                    if (t.getSellerId() == sellerAccount->getSellerId()) {
-                        sellerTransactions.push_back(&t);
+                const size_t pageSize = 10;
+                size_t offset = 0;
+                while (true) {
+                    market::OrderPage page = market::ordersForSeller(state, sellerAccount->getSellerId(), offset, pageSize);
+                    if (page.total == 0) {
+                        cout << "[X] No orders yet." << endl;
+                        break;
                     }
-                }
-                
-                for (auto& t : pendingOrders) {
-                    if (t.getSellerId() == sellerAccount->getSellerId()) {
-                        sellerTransactions.push_back(&t);
+                    if (offset == 0) cout << "Total Orders: " << page.total << " (newest first)" << endl;
+                    for (const auto& t : page.orders) {
+                        t.printTransactionDetails();
                     }
+                    offset += page.orders.size();
+                    if (page.orders.empty() || offset >= page.total) break;
+
+                    char more;
+                    cout << "\nShowing " << offset << " of " << page.total << ". Show more? (y/N): ";
+                    cin >> more;
+                    if (more != 'y' && more != 'Y') break;
                 }
-                
-                if (sellerTransactions.empty()) {
-                    cout << "[X] No orders yet." << endl;
-                } else {
-                    cout << "Total Orders: " << sellerTransactions.size() << endl;
-                    for (auto* t : sellerTransactions) {
-                        t->printTransactionDetails();
+                break;
+            }
+
+            case 6: { // Sales Report
+                cout << "\n=== SALES REPORT ===" << endl;
+                analytics::Report report = market::salesReport(state, sellerAccount->getSellerId());
+                if (report.allTime.orders == 0) {
+                    cout << "[X] No paid orders yet." << endl;
+                    break;
+                }
+                cout << "Period\t\tOrders\tUnits\tRevenue" << endl;
+                cout << "----------------------------------------------------------------" << endl;
+                auto period = [](const char* name, const analytics::Totals& t) {
+                    cout << name << "\t" << t.orders << "\t" << t.units << "\t$" << t.revenue << endl;
+                };
+                period("Today\t", report.today);
+                period("Last 7 days", report.last7Days);
+                period("Last 30 days", report.last30Days);
+                period("All time", report.allTime);
+
+                if (!report.daily.empty()) {
+                    cout << "\n--- Daily (last 30 days) ---" << endl;
+                    for (const auto& [date, t] : report.daily) {
+                        cout << dt::format(date) << "\t" << t.orders << "\t" << t.units << "\t$" << t.revenue << endl;
                     }
                 }
+                cout << "\n--- Top Items ---" << endl;
+                for (const auto& item : report.topItems) {
+                    cout << item.itemId << "\t" << item.name << "\t\t" << item.units << " sold\t$" << item.revenue << endl;
+                }
                 break;
             }
 
-            case 6: { // Delete Account
+            case 7: { // Delete Account
                 cout << "\n=== DELETE ACCOUNT ===" << endl;
                 char confirm;
                 cout << "Are you sure? This will delete both buyer and seller accounts! (y/N): ";
                 cin >> confirm;
                 
                 if (confirm == 'y' || confirm == 'Y') {
-                    int delId = sellerAccount->getId();
-                    buyers.erase(remove_if(buyers.begin(), buyers.end(),
-                        [delId](const Buyer& b) { return b.getId() == delId; }), buyers.end());
-                    sellers.erase(remove_if(sellers.begin(), sellers.end(),
-                        [delId](const seller& s) { return s.getId() == delId; }), sellers.end());
-                    bankAccounts.erase(remove_if(bankAccounts.begin(), bankAccounts.end(),
-                        [delId](const unique_ptr<BankCustomer>& acc) { return acc->getId() == delId; }), bankAccounts.end());
+                    market::deleteUser(state, journal, owner->getId());
                     cout << "\n--- Account deleted. ---" << endl;
                     logout = true;
                 } else {
@@ -767,7 +783,50 @@ void showSellerMenu(seller* sellerAccount, vector<seller>& sellers, vector<Trans
                 break;
             }
 
-            case 7: { // Logout
+            case 8: { // Import Items
+                cout << "\n=== IMPORT ITEMS ===" << endl;
+                string path;
+                cout << "File (.csv or .ndjson): ";
+                cin >> path;
+                catalog_io::Format format;
+                if (!catalog_io::formatFor(path, format)) {
+                    cout << "\n[X] Unknown file type!" << endl;
+                    break;
+                }
+                catalog_io::ImportReport report;
+                market::Status st = catalog_io::importCatalog(state, journal, sellerAccount->getSellerId(), path, format, report);
+                for (const auto& e : report.errors) cout << "[X] " << e << endl;
+                if (st != market::OK) {
+                    cout << "\n[X] Could not import " << path << "!" << endl;
+                    break;
+                }
+                cout << "\n--- Imported " << report.rows << " rows in " << report.seconds << " s ("
+                     << static_cast<long>(report.rowsPerSecond()) << " rows/s) ---" << endl;
+                cout << "Added " << report.added << ", updated " << report.updated << ", duplicates "
+                     << report.duplicates << ", rejected " << report.rejected << endl;
+                break;
+            }
+
+            case 9: { // Export Items
+                cout << "\n=== EXPORT ITEMS ===" << endl;
+                string path;
+                cout << "File (.csv or .ndjson): ";
+                cin >> path;
+                catalog_io::Format format;
+                if (!catalog_io::formatFor(path, format)) {
+                    cout << "\n[X] Unknown file type!" << endl;
+                    break;
+                }
+                catalog_io::ExportReport report;
+                if (catalog_io::exportCatalog(state, sellerAccount->getSellerId(), path, format, report) != market::OK) {
+                    cout << "\n[X] Could not write " << path << "!" << endl;
+                    break;
+                }
+                cout << "\n--- Exported " << report.rows << " items to " << path << " ---" << endl;
+                break;
+            }
+
+            case 10: { // Logout
                 cout << "\n--- Logged out successfully. ---" << endl;
                 logout = true;
                 break;
@@ -0,0 +1,172 @@
+#include "analytics.h"
+#include "datetime.h"
+#include "persistence.h"
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <unordered_map>
+
+using namespace std;
+
+namespace analytics {
+
+Totals& Totals::operator+=(const Totals& other) {
+    revenue += other.revenue;
+    orders += other.orders;
+    units += other.units;
+    return *this;
+}
+
+// Adds Totals up over many days; the revenue is checked once, in total().
+struct TotalsSum {
+    MoneySum revenue;
+    int64_t orders = 0;
+    int64_t units = 0;
+
+    void add(const Totals& t) {
+        revenue += t.revenue;
+        orders += t.orders;
+        units += t.units;
+    }
+    Totals total() const { return Totals{revenue.total(), orders, units}; }
+};
+
+static bool isSale(TransactionStatus status) {
+    return status == PAID || status == COMPLETED;
+}
+
+void SalesLedger::addHeader(int sellerId, dt::Day date, Money total) {
+    SellerSales& s = sellers[sellerId];
+    Totals order;
+    order.revenue = total;
+    order.orders = 1;
+    s.allTime += order;
+    s.days[date] += order;
+}
+
+void SalesLedger::addLine(int sellerId, dt::Day date, int itemId, string_view name, int quantity, Money lineTotal) {
+    SellerSales& s = sellers[sellerId];
+    s.allTime.units += quantity;
+    s.days[date].units += quantity;
+    ItemSales& item = s.items[itemId];
+    item.itemId = itemId;
+    item.name = name;
+    item.units += quantity;
+    item.revenue += lineTotal;
+}
+
+void SalesLedger::add(const Transaction& order) {
+    if (!isSale(order.getStatus())) return;
+    addHeader(order.getSellerId(), order.getDay(), order.getTotalAmount());
+    for (const auto& line : order.getItems()) {
+        addLine(order.getSellerId(), order.getDay(), line.getItemId(), line.getItemName(), line.getQuantity(), line.getTotalPrice());
+    }
+}
+
+void SalesLedger::rebuild(const OrderList& orders) {
+    clear();
+    for (const auto& order : orders) add(order);
+}
+
+template <typename T>
+static bool parseField(const string& tok, T& out) {
+    auto r = from_chars(tok.data(), tok.data() + tok.size(), out);
+    return r.ec == errc() && r.ptr == tok.data() + tok.size();
+}
+
+static bool parseField(const string& tok, Money& out) {
+    return Money::parse(tok, out);
+}
+
+bool SalesLedger::addTextTables(const string& dir) {
+    ifstream headers(dir + "/transactions.txt");
+    if (!headers) return false;
+    ifstream lines(dir + "/transaction_items.txt");
+
+    // Item rows are joined to their header by id through an index of the
+    // paid orders, a few bytes each, so an orphaned or out-of-order row only
+    // loses itself. Nothing else of either table is held.
+    struct Sale {
+        int sellerId;
+        dt::Day date;
+    };
+    unordered_map<int, Sale> sales;
+    string row;
+    while (getline(headers, row)) {
+        if (row.empty() || row[0] == '#') continue;
+        vector<string> cols = store::split_fields(row);
+        int id, sellerId, status;
+        Money total;
+        if (cols.size() < 8 || !parseField(cols[0], id) || !parseField(cols[3], sellerId)
+            || !parseField(cols[5], total) || !parseField(cols[6], status)) continue;
+        if (!isSale(static_cast<TransactionStatus>(status))) continue;
+        dt::Day date = dt::from_string(cols[7]);
+        // Headers of orders without item rows still count
+        if (sales.emplace(id, Sale{sellerId, date}).second) addHeader(sellerId, date, total);
+    }
+
+    while (lines && getline(lines, row)) {
+        if (row.empty() || row[0] == '#') continue;
+        vector<string> cols = store::split_fields(row);
+        int txnId, itemId, quantity;
+        Money price;
+        if (cols.size() < 5 || !parseField(cols[0], txnId) || !parseField(cols[1], itemId)
+            || !parseField(cols[3], quantity) || !parseField(cols[4], price)) continue;
+        // Lines of pending orders, and rows with no header, have no sale
+        auto sale = sales.find(txnId);
+        if (sale == sales.end()) continue;
+        addLine(sale->second.sellerId, sale->second.date, itemId, symbols::view(symbols::intern(cols[2])), quantity, price * quantity);
+    }
+    return true;
+}
+
+Totals SalesLedger::window(int sellerId, int days, dt::Day ref) const {
+    TotalsSum sum;
+    auto it = sellers.find(sellerId);
+    if (it == sellers.end() || days <= 0) return sum.total();
+    dt::Day r = ref == dt::NO_DAY ? dt::current_day() : ref;
+    const auto& byDay = it->second.days;
+    for (auto d = byDay.lower_bound(r - (days - 1)); d != byDay.end() && d->first <= r; ++d) sum.add(d->second);
+    return sum.total();
+}
+
+Report SalesLedger::report(int sellerId, size_t topItems, dt::Day ref) const {
+    Report out;
+    auto it = sellers.find(sellerId);
+    if (it == sellers.end()) return out;
+    const SellerSales& s = it->second;
+    dt::Day r = ref == dt::NO_DAY ? dt::current_day() : ref;
+
+    out.allTime = s.allTime;
+    TotalsSum last30, last7;
+    for (auto d = s.days.lower_bound(r - 29); d != s.days.end() && d->first <= r; ++d) {
+        const auto& [date, totals] = *d;
+        last30.add(totals);
+        out.daily.emplace_back(date, totals);
+        if (dt::in_last_n_days(date, 7, r)) last7.add(totals);
+        if (date == r) out.today = totals;
+    }
+    out.last30Days = last30.total();
+    out.last7Days = last7.total();
+
+    for (const auto& entry : s.items) out.topItems.push_back(entry.second);
+    auto byUnits = [](const ItemSales& a, const ItemSales& b) {
+        return a.units != b.units ? a.units > b.units : a.itemId < b.itemId;
+    };
+    size_t n = min(topItems, out.topItems.size());
+    partial_sort(out.topItems.begin(), out.topItems.begin() + static_cast<ptrdiff_t>(n), out.topItems.end(), byUnits);
+    out.topItems.resize(n);
+    return out;
+}
+
+vector<pair<int, Totals>> SalesLedger::sellerRanking() const {
+    vector<pair<int, Totals>> out;
+    out.reserve(sellers.size());
+    for (const auto& [id, s] : sellers) out.emplace_back(id, s.allTime);
+    sort(out.begin(), out.end(), [](const auto& a, const auto& b) {
+        return a.second.revenue != b.second.revenue ? a.second.revenue > b.second.revenue : a.first < b.first;
+    });
+    return out;
+}
+
+}
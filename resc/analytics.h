@@ -0,0 +1,82 @@
+#ifndef ANALYTICS_H
+#define ANALYTICS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+#include "datetime.h"
+#include "money.h"
+#include "transaction.h"
+
+using namespace std;
+
+// Sales figures for paid orders, pre-aggregated per seller and per day so a
+// report costs O(days + items sold) however many orders there were.
+namespace analytics {
+
+struct Totals {
+    Money revenue;
+    int64_t orders = 0;
+    int64_t units = 0;
+
+    Totals& operator+=(const Totals& other);
+};
+
+struct ItemSales {
+    int itemId = 0;
+    string_view name;   // interned (symbols.h), as on the most recent sale
+    int64_t units = 0;
+    Money revenue;
+};
+
+struct Report {
+    Totals allTime;
+    Totals today;
+    Totals last7Days;
+    Totals last30Days;
+    vector<pair<dt::Day, Totals>> daily;  // last 30 days with sales, oldest first
+    vector<ItemSales> topItems;           // by units sold
+};
+
+class SalesLedger {
+public:
+    static constexpr size_t TOP_ITEMS = 5;
+
+    // Counts the order if it is PAID; anything else is ignored.
+    void add(const Transaction& order);
+    void rebuild(const OrderList& orders);
+    void clear() { sellers.clear(); }
+
+    // Reads transactions.txt and transaction_items.txt from a database
+    // directory a row at a time, so the tables need not fit in memory; only
+    // the paid orders' ids, sellers and dates are kept while joining.
+    // Returns false if transactions.txt is missing.
+    bool addTextTables(const string& dir);
+
+    // `ref` is the report's "today"; NO_DAY means the current date.
+    Report report(int sellerId, size_t topItems = TOP_ITEMS, dt::Day ref = dt::NO_DAY) const;
+    // Orders dated in the n days ending at ref, as dt::in_last_n_days counts them.
+    Totals window(int sellerId, int days, dt::Day ref = dt::NO_DAY) const;
+    // Every seller's all-time totals, highest revenue first.
+    vector<pair<int, Totals>> sellerRanking() const;
+
+private:
+    struct SellerSales {
+        Totals allTime;
+        map<dt::Day, Totals> days;  // in date order
+        unordered_map<int, ItemSales> items;
+    };
+    unordered_map<int, SellerSales> sellers;
+
+    void addHeader(int sellerId, dt::Day date, Money total);
+    void addLine(int sellerId, dt::Day date, int itemId, string_view name, int quantity, Money lineTotal);
+};
+
+}
+
+#endif // ANALYTICS_H
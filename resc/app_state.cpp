@@ -0,0 +1,248 @@
+#include "app_state.h"
+#include <algorithm>
+
+using namespace std;
+
+template <typename T>
+static Handle<T> lookup(const unordered_map<int, Handle<T>>& index, int id) {
+    auto it = index.find(id);
+    return it == index.end() ? Handle<T>() : it->second;
+}
+
+BuyerHandle AppState::buyerHandle(int buyerId) const { return lookup(buyerIndex, buyerId); }
+SellerHandle AppState::sellerHandle(int sellerId) const { return lookup(sellerIndex, sellerId); }
+SellerHandle AppState::sellerHandleByBuyer(int buyerId) const { return lookup(sellerByBuyer, buyerId); }
+AccountHandle AppState::accountHandle(int accountId) const { return lookup(accountIndex, accountId); }
+
+Buyer* AppState::findBuyer(int buyerId) {
+    return buyers.get(buyerHandle(buyerId));
+}
+
+seller* AppState::findSeller(int sellerId) {
+    return sellers.get(sellerHandle(sellerId));
+}
+
+seller* AppState::findSellerByBuyer(int buyerId) {
+    return sellers.get(sellerHandleByBuyer(buyerId));
+}
+
+BankCustomer* AppState::findAccount(int accountId) {
+    return bankAccounts.get(accountHandle(accountId));
+}
+
+Item AppState::findItem(int sellerId, int itemId) {
+    auto it = itemIndex.find(itemKey(sellerId, itemId));
+    if (it == itemIndex.end()) return Item();
+    return Item(catalog, catalog.rangeOf(sellerId).begin + it->second);
+}
+
+Buyer& AppState::addBuyer(int id, string_view name, const string& email, const string& phone, const string& address, AccountHandle account) {
+    BuyerHandle h = buyers.insert(id, name, email, phone, address, account);
+    buyerIndex.emplace(id, h);
+    nextBuyerId = max(nextBuyerId, id + 1);
+    markDirty(TABLE_BUYERS);
+    return *buyers.get(h);
+}
+
+seller& AppState::addSeller(int buyerId, int sellerId, string_view storeName) {
+    SellerHandle h = sellers.insert(buyerId, sellerId, storeName);
+    sellerIndex.emplace(sellerId, h);
+    sellerByBuyer.emplace(buyerId, h);
+    nextSellerId = max(nextSellerId, sellerId + 1);
+    markDirty(TABLE_SELLERS);
+    return *sellers.get(h);
+}
+
+BankCustomer& AppState::addAccount(int id, string_view name, Money balance) {
+    AccountHandle h = bankAccounts.insert(id, name, balance);
+    accountIndex.emplace(id, h);
+    markDirty(TABLE_ACCOUNTS);
+    return *bankAccounts.get(h);
+}
+
+Item AppState::addItem(seller& s, int itemId, string_view name, int quantity, Money price) {
+    itemIndex.emplace(itemKey(s.getSellerId(), itemId), catalog.rangeOf(s.getSellerId()).size());
+    markDirty(TABLE_ITEMS);
+    search.add(s.getSellerId(), itemId, name);
+    return Item(catalog, catalog.insert(s.getSellerId(), itemId, name, quantity, price));
+}
+
+size_t AppState::addItems(seller& s, const vector<Catalog::NewRow>& rows) {
+    int sellerId = s.getSellerId();
+    size_t offset = catalog.rangeOf(sellerId).size();
+    for (size_t i = 0; i < rows.size(); i++) {
+        itemIndex.emplace(itemKey(sellerId, rows[i].itemId), offset + i);
+        search.add(sellerId, rows[i].itemId, symbols::view(rows[i].name));
+    }
+    markDirty(TABLE_ITEMS);
+    return catalog.insertMany(sellerId, rows);
+}
+
+bool AppState::updateItem(int sellerId, int itemId, string_view name, int quantity, Money price) {
+    Item item = findItem(sellerId, itemId);
+    if (!item) return false;
+    if (item.getName() != name) {
+        search.remove(sellerId, itemId, item.getName());
+        search.add(sellerId, itemId, name);
+    }
+    item.setName(name);
+    item.setQuantity(quantity);
+    item.setPrice(price);
+    markDirty(TABLE_ITEMS);
+    return true;
+}
+
+bool AppState::removeItem(int sellerId, int itemId) {
+    Item item = findItem(sellerId, itemId);
+    if (!item) return false;
+    search.remove(sellerId, itemId, item.getName());
+    // Only this seller's offsets shift
+    for (const auto& other : items(sellerId)) itemIndex.erase(itemKey(sellerId, other.getId()));
+    catalog.erase(item.getRow());
+    indexItems(sellerId);
+    markDirty(TABLE_ITEMS);
+    return true;
+}
+
+void AppState::removeUser(int buyerId) {
+    if (const seller* s = findSellerByBuyer(buyerId)) {
+        int sellerId = s->getSellerId();
+        for (const auto& item : items(sellerId)) {
+            search.remove(sellerId, item.getId(), item.getName());
+            itemIndex.erase(itemKey(sellerId, item.getId()));
+        }
+        catalog.eraseSeller(sellerId);
+        sellers.erase(sellerIndex[sellerId]);
+        sellerIndex.erase(sellerId);
+        sellerByBuyer.erase(buyerId);
+    }
+    // The account is the one opened under the buyer's id
+    bankAccounts.erase(accountHandle(buyerId));
+    accountIndex.erase(buyerId);
+    buyers.erase(buyerHandle(buyerId));
+    buyerIndex.erase(buyerId);
+    markDirty(TABLE_BUYERS | TABLE_SELLERS | TABLE_ACCOUNTS | TABLE_ITEMS);
+}
+
+void AppState::indexItems(int sellerId) {
+    Catalog::Range r = catalog.rangeOf(sellerId);
+    for (size_t row = r.begin; row < r.end; row++) {
+        itemIndex.emplace(itemKey(sellerId, catalog.itemId(row)), row - r.begin);
+    }
+}
+
+void AppState::recountReserved() {
+    for (size_t row = 0; row < catalog.size(); row++) catalog.setReserved(row, 0);
+    for (const auto& order : pendingOrders) {
+        for (const auto& line : order.getItems()) {
+            if (Item item = findItem(order.getSellerId(), line.getItemId())) {
+                item.setReserved(item.getReserved() + line.getQuantity());
+            }
+        }
+    }
+}
+
+// Ids are handed out in order but may be added slightly out of it by
+// concurrent sessions, so insert from the back.
+static void insertId(vector<int>& ids, int id) {
+    auto at = ids.end();
+    while (at != ids.begin() && *(at - 1) > id) --at;
+    ids.insert(at, id);
+}
+
+static void eraseId(unordered_map<int, vector<int>>& index, int key, int id) {
+    auto it = index.find(key);
+    if (it == index.end()) return;
+    auto& ids = it->second;
+    ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+    if (ids.empty()) index.erase(it);
+}
+
+Transaction* AppState::findOrder(int transactionId) {
+    auto it = orderIndex.find(transactionId);
+    if (it == orderIndex.end()) return nullptr;
+    return it->second.pending ? &pendingOrders[it->second.pos] : &transactions[it->second.pos];
+}
+
+const Transaction* AppState::findOrder(int transactionId) const {
+    auto it = orderIndex.find(transactionId);
+    if (it == orderIndex.end()) return nullptr;
+    return it->second.pending ? &pendingOrders[it->second.pos] : &transactions[it->second.pos];
+}
+
+Transaction* AppState::findPendingOrder(int transactionId) {
+    auto it = orderIndex.find(transactionId);
+    return it != orderIndex.end() && it->second.pending ? &pendingOrders[it->second.pos] : nullptr;
+}
+
+Transaction& AppState::addPendingOrder(Transaction& order) {
+    int id = order.getTransactionId();
+    orderIndex[id] = {true, pendingOrders.size()};
+    insertId(ordersByBuyer[order.getBuyerId()], id);
+    insertId(ordersBySeller[order.getSellerId()], id);
+    insertId(pendingByBuyer[order.getBuyerId()], id);
+    pendingOrders.push_back(&order);
+    return order;
+}
+
+Transaction& AppState::addClosedOrder(Transaction& order) {
+    int id = order.getTransactionId();
+    orderIndex[id] = {false, transactions.size()};
+    insertId(ordersByBuyer[order.getBuyerId()], id);
+    insertId(ordersBySeller[order.getSellerId()], id);
+    transactions.push_back(&order);
+    return order;
+}
+
+Transaction* AppState::closeOrder(int transactionId, TransactionStatus status) {
+    auto it = orderIndex.find(transactionId);
+    if (it == orderIndex.end() || !it->second.pending) return nullptr;
+    size_t pos = it->second.pos;
+    Transaction& order = pendingOrders[pos];
+    order.setStatus(status);
+    eraseId(pendingByBuyer, order.getBuyerId(), transactionId);
+    it->second = {false, transactions.size()};
+    transactions.push_back(&order);
+
+    pendingOrders.swapRemove(pos);
+    if (pos < pendingOrders.size()) orderIndex[pendingOrders[pos].getTransactionId()].pos = pos;
+    return &order;
+}
+
+void AppState::reindexOrders() {
+    orderIndex.clear();
+    ordersByBuyer.clear();
+    ordersBySeller.clear();
+    pendingByBuyer.clear();
+    for (size_t i = 0; i < transactions.size(); i++) {
+        const Transaction& t = transactions[i];
+        orderIndex[t.getTransactionId()] = {false, i};
+        ordersByBuyer[t.getBuyerId()].push_back(t.getTransactionId());
+        ordersBySeller[t.getSellerId()].push_back(t.getTransactionId());
+    }
+    for (size_t i = 0; i < pendingOrders.size(); i++) {
+        const Transaction& t = pendingOrders[i];
+        orderIndex[t.getTransactionId()] = {true, i};
+        ordersByBuyer[t.getBuyerId()].push_back(t.getTransactionId());
+        ordersBySeller[t.getSellerId()].push_back(t.getTransactionId());
+        pendingByBuyer[t.getBuyerId()].push_back(t.getTransactionId());
+    }
+    for (auto* index : {&ordersByBuyer, &ordersBySeller, &pendingByBuyer}) {
+        for (auto& entry : *index) sort(entry.second.begin(), entry.second.end());
+    }
+}
+
+void AppState::reindex() {
+    buyerIndex.clear();
+    sellerIndex.clear();
+    sellerByBuyer.clear();
+    accountIndex.clear();
+    itemIndex.clear();
+    for (auto it = buyers.begin(); it != buyers.end(); ++it) buyerIndex.emplace(it->getId(), it.handle());
+    for (auto it = sellers.begin(); it != sellers.end(); ++it) {
+        sellerIndex.emplace(it->getSellerId(), it.handle());
+        sellerByBuyer.emplace(it->getUserId(), it.handle());
+        indexItems(it->getSellerId());
+    }
+    for (auto it = bankAccounts.begin(); it != bankAccounts.end(); ++it) accountIndex.emplace(it->getId(), it.handle());
+}
@@ -0,0 +1,182 @@
+#ifndef APP_STATE_H
+#define APP_STATE_H
+
+#include <atomic>
+#include <cstdint>
+#include <memory>
+#include <memory_resource>
+#include <mutex>
+#include <shared_mutex>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "buyer.h"
+#include "seller.h"
+#include "catalog.h"
+#include "item.h"
+#include "search_index.h"
+#include "analytics.h"
+#include "bank_customer.h"
+#include "transaction.h"
+#include "arena.h"
+#include "row_locks.h"
+#include "slot_map.h"
+
+using namespace std;
+
+// Snapshot tables, as bit flags for dirty tracking.
+enum DataTable : unsigned {
+    TABLE_BUYERS = 1u << 0,
+    TABLE_SELLERS = 1u << 1,
+    TABLE_ACCOUNTS = 1u << 2,
+    TABLE_ITEMS = 1u << 3,
+    TABLE_TRANSACTIONS = 1u << 4,
+    TABLE_PENDING = 1u << 5,
+    TABLE_ALL = (1u << 6) - 1
+};
+
+// The one long-lived copy of all marketplace data; it is never copied.
+struct AppState {
+    AppState() = default;
+    AppState(const AppState&) = delete;
+    AppState& operator=(const AppState&) = delete;
+
+    // Users live in slot maps: entries never move, and a handle to one
+    // stops resolving once it is removed, so holding a handle across other
+    // sessions' registrations or upgrades is always safe. Pointers from the
+    // find helpers stay valid until the entry is removed.
+    SlotMap<Buyer> buyers;
+    SlotMap<seller> sellers;
+    SlotMap<BankCustomer> bankAccounts;
+    // Every order is allocated once in orderArena, its line items in
+    // linePool, and never moves; the two lists only point at them, so paying
+    // or cancelling relinks an order instead of copying it. Create orders
+    // with createOrder and link them with the order helpers below.
+    std::pmr::unsynchronized_pool_resource linePool;
+    Arena<Transaction> orderArena;
+    OrderList transactions;
+    OrderList pendingOrders;
+    // Every seller's items, in columns; see catalog.h.
+    Catalog catalog;
+    // Item names across all sellers; the item helpers below keep it current.
+    SearchIndex search;
+    // Paid-order totals per seller and day; guarded by `orders` like the
+    // vectors it is built from.
+    analytics::SalesLedger sales;
+
+    // Primary-key indexes. Users are stored by handle. Items are stored by
+    // offset into their seller's catalog range, which adding other sellers'
+    // items does not change.
+    // Go through the add/remove helpers below so the indexes stay in sync.
+    unordered_map<int, BuyerHandle> buyerIndex;     // buyer id -> buyers
+    unordered_map<int, SellerHandle> sellerIndex;   // seller id -> sellers
+    unordered_map<int, SellerHandle> sellerByBuyer; // buyer id -> sellers
+    unordered_map<int, AccountHandle> accountIndex; // account id -> bankAccounts
+    unordered_map<uint64_t, size_t> itemIndex;      // (seller id, item id) -> offset in seller's range
+
+    // Order indexes, kept by the order helpers below. `transactions` only
+    // grows; pendingOrders fills an unlinked order's slot with its last entry.
+    // Id lists are oldest first, so reading them backwards is newest first.
+    struct OrderRef {
+        bool pending;
+        size_t pos;   // in pendingOrders or transactions
+    };
+    unordered_map<int, OrderRef> orderIndex;          // transaction id -> order
+    unordered_map<int, vector<int>> ordersByBuyer;    // buyer id -> every order
+    unordered_map<int, vector<int>> ordersBySeller;   // seller id -> every order
+    unordered_map<int, vector<int>> pendingByBuyer;   // buyer id -> pending orders
+
+    // Next free ids, kept above every id added so far.
+    int nextBuyerId = 1;
+    int nextSellerId = 1;
+
+    // Tables changed since the last snapshot; save_all rewrites only these.
+    // The add/remove helpers mark their own tables, direct edits must call markDirty.
+    std::atomic<unsigned> dirty{0};
+    void markDirty(unsigned tables) { dirty.fetch_or(tables, std::memory_order_relaxed); }
+    bool isDirty(DataTable table) const { return (dirty.load(std::memory_order_relaxed) & table) != 0; }
+    void clearDirty() { dirty.store(0, std::memory_order_relaxed); }
+    // Set by load_all when snapshot.bin failed its checks; save_all then
+    // refuses to overwrite it with whatever this state holds.
+    bool snapshotCorrupt = false;
+    // Journal generations below this are already in the snapshot; load_all
+    // reads it from there and save_all writes it back.
+    uint64_t coveredJournals = 0;
+
+    // Locking for concurrent sessions, always acquired in this order:
+    //   structure -> rowLocks -> orders
+    // Adding or removing rows, and anything that reindexes, holds `structure`
+    // exclusively. Everything else holds it shared plus the row stripes it
+    // reads or writes. `orders` guards the two order vectors themselves.
+    // Single-threaded callers (the console menus) may ignore all of this.
+    mutable std::shared_mutex structure;
+    RowLocks rowLocks;
+    mutable std::mutex orders;
+
+    Buyer* findBuyer(int buyerId);
+    seller* findSeller(int sellerId);
+    seller* findSellerByBuyer(int buyerId);
+    // The user a storefront belongs to.
+    Buyer* ownerOf(const seller& s) { return findBuyer(s.getUserId()); }
+    BankCustomer* findAccount(int accountId);
+    // Handles for the same lookups; empty if there is no such entry.
+    BuyerHandle buyerHandle(int buyerId) const;
+    SellerHandle sellerHandle(int sellerId) const;
+    SellerHandle sellerHandleByBuyer(int buyerId) const;
+    AccountHandle accountHandle(int accountId) const;
+    // The user's bank account, or nullptr if none is linked.
+    BankCustomer* accountOf(const Buyer& user) { return bankAccounts.get(user.getAccount()); }
+    const BankCustomer* accountOf(const Buyer& user) const { return bankAccounts.get(user.getAccount()); }
+    // An empty Item if there is none.
+    Item findItem(int sellerId, int itemId);
+    ItemRange items(int sellerId) { return ItemRange(catalog, catalog.rangeOf(sellerId)); }
+
+    Buyer& addBuyer(int id, string_view name, const string& email, const string& phone, const string& address, AccountHandle account);
+    // Opens a storefront for an existing user.
+    seller& addSeller(int buyerId, int sellerId, string_view storeName);
+    BankCustomer& addAccount(int id, string_view name, Money balance);
+    Item addItem(seller& s, int itemId, string_view name, int quantity, Money price);
+    // Adds items none of which the seller has yet; returns the first new
+    // row, the rest follow it.
+    size_t addItems(seller& s, const vector<Catalog::NewRow>& rows);
+    // Replaces an existing item's name, stock and price.
+    bool updateItem(int sellerId, int itemId, string_view name, int quantity, Money price);
+    bool removeItem(int sellerId, int itemId);
+    // Drops the buyer, its seller profile and its bank account.
+    void removeUser(int buyerId);
+
+    // Order helpers; the caller holds `orders` (the arenas are not thread-safe).
+    // A new order in the arena, not yet in either list; takes Transaction's
+    // constructor arguments.
+    template <typename... Args>
+    Transaction& createOrder(Args&&... args) {
+        return *orderArena.create(std::forward<Args>(args)..., &linePool);
+    }
+    Transaction* findOrder(int transactionId);
+    const Transaction* findOrder(int transactionId) const;
+    // nullptr unless the order is pending.
+    Transaction* findPendingOrder(int transactionId);
+    // Link an order made by createOrder into pendingOrders or transactions.
+    Transaction& addPendingOrder(Transaction& order);
+    Transaction& addClosedOrder(Transaction& order);
+    // Relinks a pending order into `transactions` with its final status;
+    // nullptr if it is not pending.
+    Transaction* closeOrder(int transactionId, TransactionStatus status);
+
+    // Rebuilds every index from the slot maps and catalog, e.g. after bulk edits.
+    void reindex();
+    // The same for the order indexes, after the order vectors were loaded.
+    void reindexOrders();
+    // Sets each item's reserved count to what the pending orders hold.
+    void recountReserved();
+
+    static uint64_t itemKey(int sellerId, int itemId) {
+        return (static_cast<uint64_t>(static_cast<uint32_t>(sellerId)) << 32) | static_cast<uint32_t>(itemId);
+    }
+
+private:
+    void indexItems(int sellerId);
+};
+
+#endif // APP_STATE_H
@@ -0,0 +1,50 @@
+#ifndef ARENA_H
+#define ARENA_H
+
+#include <cstddef>
+#include <memory>
+#include <new>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// Append-only object storage in fixed-size blocks. Objects are constructed
+// in place and never move, so pointers to them stay valid for the arena's
+// lifetime; nothing is destroyed until the arena is cleared or destroyed.
+// Not thread-safe: the owner serializes create().
+template <typename T, size_t BLOCK = 1024>
+class Arena {
+public:
+    Arena() = default;
+    Arena(const Arena&) = delete;
+    Arena& operator=(const Arena&) = delete;
+    ~Arena() { clear(); }
+
+    template <typename... Args>
+    T* create(Args&&... args) {
+        if (count == blocks.size() * BLOCK) blocks.push_back(make_unique<Slot[]>(BLOCK));
+        T* obj = new (&blocks[count / BLOCK][count % BLOCK]) T(std::forward<Args>(args)...);
+        count++;
+        return obj;
+    }
+
+    size_t size() const { return count; }
+
+    // Destroys every object, newest first, and keeps the blocks for reuse.
+    void clear() {
+        while (count > 0) {
+            count--;
+            std::launder(reinterpret_cast<T*>(&blocks[count / BLOCK][count % BLOCK]))->~T();
+        }
+    }
+
+private:
+    struct alignas(T) Slot {
+        unsigned char bytes[sizeof(T)];
+    };
+    vector<unique_ptr<Slot[]>> blocks;
+    size_t count = 0;
+};
+
+#endif // ARENA_H
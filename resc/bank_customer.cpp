@@ -4,36 +4,28 @@
 
 using namespace std;
 
-string BankCustomer::getName() const {
-    return this->name;
+string_view BankCustomer::getName() const {
+    return symbols::view(this->name);
 }
 
 int BankCustomer::getId() const {
     return this->id ;
 }
 
-double BankCustomer::getBalance() const {
+Money BankCustomer::getBalance() const {
     return this->balance;
 }
 
-void BankCustomer::setBalance(double amount) {
+void BankCustomer::setBalance(Money amount) {
     this->balance = amount;
 }
  
-void BankCustomer::addBalance(int amount) {
-    bool wasDormant = isDormant();
+void BankCustomer::addBalance(Money amount) {
     this->balance += amount;
-    
-    // Show reactivation message if account was dormant
-    if (wasDormant && !isDormant()) {
-        cout << "\nACCOUNT REACTIVATED!" << endl;
-        cout << "   Your account is now active with balance: $" << fixed << setprecision(2) << this->balance << endl;
-    }
 }
 
-bool BankCustomer::withdrawBalance(double amount){
+bool BankCustomer::withdrawBalance(Money amount){
     if (amount > this->balance) {
-    cout << "Rejected: Insufficient funds!" << endl;
         return false;
     }
     this->balance -= amount;
@@ -41,9 +33,9 @@ bool BankCustomer::withdrawBalance(double amount){
 }
 
 void BankCustomer::printInfo() const {
-    cout << "Customer Name: " << this->name << endl;
+    cout << "Customer Name: " << getName() << endl;
     cout << "Customer ID: " << this->id << endl;
-    cout << "Balance: $" << fixed << setprecision(2) << this->balance << endl;
+    cout << "Balance: $" << this->balance << endl;
     
     // Show dormant status if balance is 0 or below
     if (isDormant()) {
@@ -53,5 +45,5 @@ void BankCustomer::printInfo() const {
 }
 
 bool BankCustomer::isDormant() const {
-    return this->balance <= 0;
+    return this->balance <= Money();
 }
\ No newline at end of file
@@ -1,29 +1,36 @@
 #ifndef BANK_CUSTOMER_H
 #define BANK_CUSTOMER_H
 
-#include <string>
+#include <string_view>
+#include "money.h"
+#include "slot_map.h"
+#include "symbols.h"
 
 using namespace std;
 
 class BankCustomer {
 private:
     int id;
-    string name;
-    double balance;
+    symbols::Id name;
+    Money balance;
 
 public:
-    BankCustomer(int id, const string& name, double balance) : id(id), name(name), balance(balance) {}
+    BankCustomer(int id, string_view name, Money balance) : id(id), name(symbols::intern(name)), balance(balance) {}
 
     int getId() const;
-    string getName() const;
-    double getBalance() const;
+    string_view getName() const;
+    symbols::Id getNameId() const { return name; }
+    Money getBalance() const;
 
     void printInfo() const;
-    void setName(const string& name);
-    void setBalance(double balance);
-    void addBalance(int amout);
-    bool withdrawBalance(double amout);
+    void setName(string_view name);
+    void setBalance(Money balance);
+    // Silent, as they run on server threads; callers report the outcome.
+    void addBalance(Money amount);
+    bool withdrawBalance(Money amount);  // false, unchanged, if it would overdraw
     bool isDormant() const;  // Check if account balance is 0 or below
 };
 
+using AccountHandle = Handle<BankCustomer>;
+
 #endif // BANK_CUSTOMER_H
\ No newline at end of file
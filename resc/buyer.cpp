@@ -3,35 +3,35 @@
 #include <algorithm>
 using namespace std;
 
-Buyer::Buyer(int id, const string& name, const string& email, const string& phone, const string& address, BankCustomer* account) 
-    : id(id), name(name), email(email), phone(phone), address(address), account(account) {}
+Buyer::Buyer(int id, string_view name, const string& email, const string& phone, const string& address, AccountHandle account) 
+    : id(id), name(symbols::intern(name)), email(email), phone(phone), address(address), account(account) {}
 
 int Buyer::getId() const {
     return id;
 }
 
-string Buyer::getName() const {
-    return name;
+string_view Buyer::getName() const {
+    return symbols::view(name);
 }
 
-string Buyer::getEmail() const {
+const string& Buyer::getEmail() const {
     return email;
 }
 
-string Buyer::getPhone() const {
+const string& Buyer::getPhone() const {
     return phone;
 }
 
-string Buyer::getAddress() const {
+const string& Buyer::getAddress() const {
     return address;
 }
 
-BankCustomer* Buyer::getAccount() const {
+AccountHandle Buyer::getAccount() const {
     return account;
 }
 
-void Buyer::setName(const string& newName) {
-    name = newName;
+void Buyer::setName(string_view newName) {
+    name = symbols::intern(newName);
 }
 
 void Buyer::setEmail(const string& newEmail) {
@@ -46,7 +46,7 @@ void Buyer::setAddress(const string& newAddress) {
     address = newAddress;
 }
 
-void Buyer::setAccount(BankCustomer* acc) {
+void Buyer::setAccount(AccountHandle acc) {
     account = acc;
 }
 
@@ -3,35 +3,41 @@
 
 #include <cstddef>
 #include <string>
+#include <string_view>
 #include "bank_customer.h"
+#include "symbols.h"
 
 using namespace std;
 
 class Buyer {
 private:
     int id;
-    string name, email, phone, address;
-    BankCustomer *account;
+    symbols::Id name;
+    string email, phone, address;
+    AccountHandle account;   // resolve with AppState::accountOf
 
 public:
-    Buyer(int id, const string& name, const string& email, const string& phone, const string& address, BankCustomer *account0);
+    Buyer(int id, string_view name, const string& email, const string& phone, const string& address, AccountHandle account);
 
     int getId() const;
-    string getName() const;
-    string getEmail() const;
-    string getPhone() const;
-    string getAddress() const;
-    BankCustomer* getAccount() const;
+    string_view getName() const;
+    symbols::Id getNameId() const { return name; }
+    const string& getEmail() const;
+    const string& getPhone() const;
+    const string& getAddress() const;
+    AccountHandle getAccount() const;
 
     void setId(int newId) { id = newId; }
-    void setName(const string& newName);
+    void setName(string_view newName);
     void setEmail(const string& newEmail);
     void setPhone(const string& newPhone);
     void setAddress(const string& newAddress);
-    void setAccount(BankCustomer* acc);
+    void setAccount(AccountHandle acc);
     
     static bool isValidEmail(const string& email);
     static bool isValidPhone(const string& phone);
 };
 
+using BuyerHandle = Handle<Buyer>;
+
 #endif // BUYER_H
\ No newline at end of file
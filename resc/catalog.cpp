@@ -0,0 +1,200 @@
+#include "catalog.h"
+#include <algorithm>
+#include <limits>
+#include <type_traits>
+
+using namespace std;
+
+static size_t words(size_t bits) { return (bits + 63) / 64; }
+
+// Opens a slot for bit `pos` in a bitmap of `count` bits and sets it to `on`.
+static void insertBit(vector<uint64_t> &bits, size_t pos, size_t count, bool on) {
+    bits.resize(words(count + 1), 0);
+    size_t w = pos / 64;
+    uint64_t low = (uint64_t(1) << (pos % 64)) - 1;
+    // Higher words move up one bit, taking the top bit of the word below
+    for (size_t i = bits.size() - 1; i > w; i--) bits[i] = (bits[i] << 1) | (bits[i - 1] >> 63);
+    bits[w] = (bits[w] & low) | ((bits[w] & ~low) << 1) | (uint64_t(on) << (pos % 64));
+}
+
+// Opens n zero bits at `pos` in a bitmap of `count` bits.
+static void insertBits(vector<uint64_t> &bits, size_t pos, size_t n, size_t count) {
+    bits.resize(words(count + n), 0);
+    for (size_t i = count; i-- > pos;) {
+        uint64_t bit = (bits[i / 64] >> (i % 64)) & 1;
+        size_t to = i + n;
+        bits[to / 64] = (bits[to / 64] & ~(uint64_t(1) << (to % 64))) | (bit << (to % 64));
+    }
+    for (size_t i = pos; i < pos + n && i < count; i++) bits[i / 64] &= ~(uint64_t(1) << (i % 64));
+}
+
+// Removes bits [pos, pos + n) from a bitmap of `count` bits; the tail stays zero.
+static void eraseBits(vector<uint64_t> &bits, size_t pos, size_t n, size_t count) {
+    for (size_t i = pos; i + n < count; i++) {
+        uint64_t bit = (bits[(i + n) / 64] >> ((i + n) % 64)) & 1;
+        bits[i / 64] = (bits[i / 64] & ~(uint64_t(1) << (i % 64))) | (bit << (i % 64));
+    }
+    for (size_t i = count - n; i < count && i / 64 < bits.size(); i++) bits[i / 64] &= ~(uint64_t(1) << (i % 64));
+    bits.resize(words(count - n));
+}
+
+template <typename T>
+static void eraseRows(vector<T> &column, size_t pos, size_t n) {
+    column.erase(column.begin() + static_cast<ptrdiff_t>(pos), column.begin() + static_cast<ptrdiff_t>(pos + n));
+}
+
+template <typename T>
+static void insertRow(vector<T> &column, size_t pos, T value) {
+    column.insert(column.begin() + static_cast<ptrdiff_t>(pos), value);
+}
+
+Catalog::Range Catalog::rangeOf(int sellerId) const {
+    auto it = ranges.find(sellerId);
+    return it == ranges.end() ? Range{} : it->second;
+}
+
+void Catalog::shiftRanges(size_t from, int delta, int except) {
+    for (auto &[id, r] : ranges) {
+        if (id == except || r.begin < from) continue;
+        r.begin = static_cast<uint32_t>(static_cast<int64_t>(r.begin) + delta);
+        r.end = static_cast<uint32_t>(static_cast<int64_t>(r.end) + delta);
+    }
+}
+
+size_t Catalog::insert(int sellerId, int itemId, string_view name, int quantity, Money price) {
+    size_t count = size();
+    auto it = ranges.find(sellerId);
+    if (it == ranges.end()) {
+        uint32_t end = static_cast<uint32_t>(count);
+        it = ranges.emplace(sellerId, Range{end, end}).first;
+    }
+    size_t at = it->second.end;
+    // Loading appends seller by seller, so this is nearly always the tail
+    insertRow(sellerIds, at, static_cast<int32_t>(sellerId));
+    insertRow(itemIds, at, static_cast<int32_t>(itemId));
+    insertRow(quantities, at, static_cast<int32_t>(quantity));
+    insertRow(reserved, at, int32_t(0));
+    insertRow(prices, at, price.cents());
+    insertRow(nameIds, at, symbols::intern(name));
+    insertBit(visible, at, count, false);
+    // Ranges are never empty, so appending at the tail moves no other range
+    if (at < count) shiftRanges(at, 1, sellerId);
+    it->second.end++;
+    return at;
+}
+
+size_t Catalog::insertMany(int sellerId, const vector<NewRow> &rows) {
+    size_t count = size();
+    auto it = ranges.find(sellerId);
+    if (it == ranges.end()) {
+        if (rows.empty()) return count;
+        uint32_t end = static_cast<uint32_t>(count);
+        it = ranges.emplace(sellerId, Range{end, end}).first;
+    }
+    size_t at = it->second.end;
+    size_t n = rows.size();
+    auto fill = [&](auto &column, auto get) {
+        using T = typename std::remove_reference_t<decltype(column)>::value_type;
+        column.insert(column.begin() + static_cast<ptrdiff_t>(at), n, T());
+        for (size_t i = 0; i < n; i++) column[at + i] = get(rows[i]);
+    };
+    fill(sellerIds, [&](const NewRow &) { return static_cast<int32_t>(sellerId); });
+    fill(itemIds, [](const NewRow &r) { return static_cast<int32_t>(r.itemId); });
+    fill(quantities, [](const NewRow &r) { return static_cast<int32_t>(r.quantity); });
+    fill(reserved, [](const NewRow &) { return int32_t(0); });
+    fill(prices, [](const NewRow &r) { return r.price.cents(); });
+    fill(nameIds, [](const NewRow &r) { return r.name; });
+    insertBits(visible, at, n, count);
+    if (at < count) shiftRanges(at, static_cast<int>(n), sellerId);
+    it->second.end += static_cast<uint32_t>(n);
+    return at;
+}
+
+void Catalog::erase(size_t row) {
+    size_t count = size();
+    int owner = sellerIds[row];
+    eraseRows(sellerIds, row, 1);
+    eraseRows(itemIds, row, 1);
+    eraseRows(quantities, row, 1);
+    eraseRows(reserved, row, 1);
+    eraseRows(prices, row, 1);
+    eraseRows(nameIds, row, 1);
+    eraseBits(visible, row, 1, count);
+    auto it = ranges.find(owner);
+    if (--it->second.end == it->second.begin) ranges.erase(it);
+    shiftRanges(row + 1, -1, owner);
+}
+
+void Catalog::eraseSeller(int sellerId) {
+    auto it = ranges.find(sellerId);
+    if (it == ranges.end()) return;
+    Range r = it->second;
+    ranges.erase(it);
+    if (r.empty()) return;
+    size_t count = size();
+    eraseRows(sellerIds, r.begin, r.size());
+    eraseRows(itemIds, r.begin, r.size());
+    eraseRows(quantities, r.begin, r.size());
+    eraseRows(reserved, r.begin, r.size());
+    eraseRows(prices, r.begin, r.size());
+    eraseRows(nameIds, r.begin, r.size());
+    eraseBits(visible, r.begin, r.size(), count);
+    shiftRanges(r.end, -static_cast<int>(r.size()), sellerId);
+}
+
+void Catalog::clear() {
+    sellerIds.clear();
+    itemIds.clear();
+    quantities.clear();
+    reserved.clear();
+    prices.clear();
+    nameIds.clear();
+    visible.clear();
+    ranges.clear();
+}
+
+void Catalog::setVisible(size_t row, bool on) {
+    uint64_t bit = uint64_t(1) << (row % 64);
+    if (on) visible[row / 64] |= bit;
+    else visible[row / 64] &= ~bit;
+}
+
+bool Catalog::tryReserve(size_t row, int n) {
+    atomic_ref<int32_t> available = stock(quantities, row);
+    int have = available.load(memory_order_relaxed);
+    do {
+        if (have < n) return false;
+    } while (!available.compare_exchange_weak(have, have - n, memory_order_relaxed));
+    stock(reserved, row).fetch_add(n, memory_order_relaxed);
+    return true;
+}
+
+void Catalog::release(size_t row, int n) {
+    stock(reserved, row).fetch_sub(n, memory_order_relaxed);
+    stock(quantities, row).fetch_add(n, memory_order_relaxed);
+}
+
+void Catalog::consume(size_t row, int n) {
+    stock(reserved, row).fetch_sub(n, memory_order_relaxed);
+}
+
+Money Catalog::stockValue(Range rows) const {
+    // The products are added modulo 2^64 with no check per row. Every partial
+    // sum is at most (units in stock) * (largest price) in magnitude, so if
+    // that bound fits, the wrapped total is exact.
+    uint64_t wrapped = 0, units = 0, maxPrice = 0;
+    for (size_t r = rows.begin; r < rows.end; r++) {
+        int64_t q = quantities[r], p = prices[r];
+        wrapped += static_cast<uint64_t>(q) * static_cast<uint64_t>(p);
+        units += static_cast<uint64_t>(q < 0 ? -q : q);
+        uint64_t magnitude = p < 0 ? 0 - static_cast<uint64_t>(p) : static_cast<uint64_t>(p);
+        maxPrice = max(maxPrice, magnitude);
+    }
+    if (units == 0 || maxPrice <= static_cast<uint64_t>(numeric_limits<int64_t>::max()) / units) {
+        return Money::fromCents(static_cast<int64_t>(wrapped));
+    }
+    // Too large to vouch for: redo it checked, which throws if it overflows
+    Money total;
+    for (size_t r = rows.begin; r < rows.end; r++) total += price(r) * quantity(r);
+    return total;
+}
@@ -0,0 +1,111 @@
+#ifndef CATALOG_H
+#define CATALOG_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+#include "money.h"
+#include "symbols.h"
+
+using namespace std;
+
+// Every seller's items, stored as one column per field so scans over stock,
+// price or visibility read only the bytes they test. Each seller's rows are
+// contiguous; rangeOf() gives the slice, and adding an item appends to it.
+//
+// Item names are interned in the global symbol table, so repeated names
+// share one string and the row holds just its 32-bit id.
+//
+// Stock (quantity/reserved) is read and written through atomic_ref, so
+// concurrent orders on the same row need no lock. Adding or erasing rows
+// moves the columns and needs AppState::structure held exclusively.
+class Catalog {
+public:
+    struct Range {
+        uint32_t begin = 0;
+        uint32_t end = 0;
+        size_t size() const { return end - begin; }
+        bool empty() const { return begin == end; }
+    };
+
+    size_t size() const { return itemIds.size(); }
+    Range rangeOf(int sellerId) const;
+
+    struct NewRow {
+        int itemId;
+        symbols::Id name;
+        int quantity;
+        Money price;
+    };
+
+    // Appends a row at the end of the seller's range and returns its index.
+    size_t insert(int sellerId, int itemId, string_view name, int quantity, Money price);
+    // The same for many rows at once, moving the rows after the range only
+    // once; returns the index of the first.
+    size_t insertMany(int sellerId, const vector<NewRow> &rows);
+    void erase(size_t row);
+    // Drops all of a seller's rows.
+    void eraseSeller(int sellerId);
+    void clear();
+
+    int sellerId(size_t row) const { return sellerIds[row]; }
+    int itemId(size_t row) const { return itemIds[row]; }
+    string_view name(size_t row) const { return symbols::view(nameIds[row]); }
+    symbols::Id nameId(size_t row) const { return nameIds[row]; }
+    Money price(size_t row) const { return Money::fromCents(prices[row]); }
+    bool isVisible(size_t row) const { return (visible[row / 64] >> (row % 64)) & 1; }
+
+    void setName(size_t row, string_view name) { nameIds[row] = symbols::intern(name); }
+    void setPrice(size_t row, Money price) { prices[row] = price.cents(); }
+    void setVisible(size_t row, bool on);
+
+    // Available to order, i.e. not held by a pending order.
+    int quantity(size_t row) const { return stock(quantities, row).load(memory_order_relaxed); }
+    int reservedQuantity(size_t row) const { return stock(reserved, row).load(memory_order_relaxed); }
+    void setQuantity(size_t row, int n) { stock(quantities, row).store(n, memory_order_relaxed); }
+    void setReserved(size_t row, int n) { stock(reserved, row).store(n, memory_order_relaxed); }
+
+    // Moves n units from available to reserved if that many are available.
+    bool tryReserve(size_t row, int n);
+    // The order was cancelled: reserved units become available again.
+    void release(size_t row, int n);
+    // The order was paid: reserved units leave the inventory.
+    void consume(size_t row, int n);
+
+    // Sum of quantity * price over the rows, i.e. what the available stock is
+    // listed at. Throws overflow_error if it does not fit in a Money.
+    Money stockValue(Range rows) const;
+
+    // Raw columns for scans; element r of each belongs to row r. The
+    // visibility bitmap holds bit r % 64 of word r / 64.
+    const vector<int32_t> &sellerColumn() const { return sellerIds; }
+    const vector<int32_t> &itemColumn() const { return itemIds; }
+    const vector<int32_t> &quantityColumn() const { return quantities; }
+    const vector<int32_t> &reservedColumn() const { return reserved; }
+    const vector<int64_t> &priceColumn() const { return prices; }
+    const vector<symbols::Id> &nameColumn() const { return nameIds; }
+    const vector<uint64_t> &visibleBitmap() const { return visible; }
+
+private:
+    vector<int32_t> sellerIds;
+    vector<int32_t> itemIds;
+    vector<int32_t> quantities;
+    vector<int32_t> reserved;
+    vector<int64_t> prices;     // in cents
+    vector<symbols::Id> nameIds;
+    vector<uint64_t> visible;
+
+    unordered_map<int, Range> ranges;  // seller id -> rows; sellers without items have none
+
+    // Moves every range at or after `from` (other than `except`) by delta rows.
+    void shiftRanges(size_t from, int delta, int except);
+
+    static atomic_ref<int32_t> stock(const vector<int32_t> &column, size_t row) {
+        return atomic_ref<int32_t>(const_cast<int32_t &>(column[row]));
+    }
+};
+
+#endif // CATALOG_H
@@ -0,0 +1,572 @@
+#include "catalog_io.h"
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <filesystem>
+#include <fstream>
+#include <functional>
+#include <mutex>
+#include <shared_mutex>
+#include <thread>
+#include <unordered_set>
+#include "persistence.h"
+
+using namespace std;
+
+namespace catalog_io {
+
+using Clock = chrono::steady_clock;
+using Shared = shared_lock<shared_mutex>;
+using Exclusive = unique_lock<shared_mutex>;
+
+bool formatFor(const string& path, Format& out) {
+    size_t dot = path.find_last_of('.');
+    if (dot == string::npos) return false;
+    string ext = path.substr(dot + 1);
+    for (char& c : ext) c = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+    if (ext == "csv") out = Format::CSV;
+    else if (ext == "ndjson" || ext == "jsonl" || ext == "json") out = Format::NDJSON;
+    else return false;
+    return true;
+}
+
+const char* formatName(Format format) {
+    return format == Format::CSV ? "CSV" : "NDJSON";
+}
+
+namespace {
+
+// Where each field sits in a CSV row.
+struct Columns {
+    size_t id = 0, name = 1, quantity = 2, price = 3;
+    size_t needed() const { return max({id, name, quantity, price}) + 1; }
+};
+
+// One record. `error` is null if it passed validation; `name` is only set
+// then. Names are interned when the row is applied, not while parsing, so
+// duplicates and rejected rows never reach the symbol table.
+struct Row {
+    size_t line = 0;
+    int itemId = 0;
+    string name;
+    int quantity = 0;
+    Money price;
+    const char* error = nullptr;
+};
+
+// A run of whole lines parsed by one thread. Row lines count from the
+// part's start until the part is placed in the file.
+struct Part {
+    string_view text;
+    vector<Row> rows;
+    size_t lines = 0;
+};
+
+}
+
+static string_view trim(string_view s) {
+    while (!s.empty() && (s.front() == ' ' || s.front() == '\t')) s.remove_prefix(1);
+    while (!s.empty() && (s.back() == ' ' || s.back() == '\t')) s.remove_suffix(1);
+    return s;
+}
+
+template <typename T>
+static bool parseInt(string_view text, T& out) {
+    auto r = from_chars(text.data(), text.data() + text.size(), out);
+    return r.ec == errc() && r.ptr == text.data() + text.size();
+}
+
+// The text tables split on '|' and lines, so names may hold neither.
+static bool storableName(string_view name) {
+    return none_of(name.begin(), name.end(), [](char c) {
+        unsigned char u = static_cast<unsigned char>(c);
+        return c == '|' || u < 0x20 || u == 0x7f;
+    });
+}
+
+static const char* validate(string_view id, string_view name, string_view quantity, string_view price, Row& row) {
+    if (!parseInt(id, row.itemId)) return "bad item id";
+    if (row.itemId < 0) return "negative item id";
+    if (name.empty()) return "empty name";
+    if (!storableName(name)) return "name holds '|' or a control character";
+    if (!parseInt(quantity, row.quantity)) return "bad quantity";
+    if (row.quantity < 0) return "negative quantity";
+    if (!Money::parse(price, row.price)) return "bad price";
+    if (row.price < Money()) return "negative price";
+    row.name.assign(name);
+    return nullptr;
+}
+
+// Splits one CSV line into fields; false on an unterminated quote.
+// Unquoted fields are trimmed, quoted ones kept as written.
+static bool splitCsv(string_view line, vector<string>& fields) {
+    fields.clear();
+    size_t i = 0;
+    while (true) {
+        string field;
+        size_t start = i;
+        while (i < line.size() && (line[i] == ' ' || line[i] == '\t')) i++;
+        if (i < line.size() && line[i] == '"') {
+            for (i++;; i++) {
+                if (i >= line.size()) return false;
+                if (line[i] == '"') {
+                    if (i + 1 < line.size() && line[i + 1] == '"') {
+                        field += '"';
+                        i++;
+                        continue;
+                    }
+                    i++;
+                    break;
+                }
+                field += line[i];
+            }
+            while (i < line.size() && line[i] != ',') i++;
+        } else {
+            size_t end = min(line.find(',', start), line.size());
+            field = trim(line.substr(start, end - start));
+            i = end;
+        }
+        fields.push_back(move(field));
+        if (i >= line.size()) return true;
+        i++;
+    }
+}
+
+static const char* parseCsv(string_view line, const Columns& cols, vector<string>& fields, Row& row) {
+    if (!splitCsv(line, fields)) return "unterminated quote";
+    if (fields.size() < cols.needed()) return "too few fields";
+    return validate(fields[cols.id], fields[cols.name], fields[cols.quantity], fields[cols.price], row);
+}
+
+static void appendUtf8(string& out, uint32_t cp) {
+    if (cp < 0x80) {
+        out += static_cast<char>(cp);
+    } else if (cp < 0x800) {
+        out += static_cast<char>(0xc0 | (cp >> 6));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    } else if (cp < 0x10000) {
+        out += static_cast<char>(0xe0 | (cp >> 12));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    } else {
+        out += static_cast<char>(0xf0 | (cp >> 18));
+        out += static_cast<char>(0x80 | ((cp >> 12) & 0x3f));
+        out += static_cast<char>(0x80 | ((cp >> 6) & 0x3f));
+        out += static_cast<char>(0x80 | (cp & 0x3f));
+    }
+}
+
+// Just enough JSON for one flat object per line.
+class JsonCursor {
+public:
+    explicit JsonCursor(string_view text) : s(text) {}
+
+    void ws() {
+        while (i < s.size() && (s[i] == ' ' || s[i] == '\t' || s[i] == '\r' || s[i] == '\n')) i++;
+    }
+    bool eat(char c) {
+        ws();
+        if (i < s.size() && s[i] == c) {
+            i++;
+            return true;
+        }
+        return false;
+    }
+    bool atEnd() {
+        ws();
+        return i == s.size();
+    }
+
+    bool str(string& out) {
+        out.clear();
+        if (!eat('"')) return false;
+        while (i < s.size()) {
+            char c = s[i++];
+            if (c == '"') return true;
+            if (c != '\\') {
+                out += c;
+                continue;
+            }
+            if (i >= s.size()) return false;
+            switch (s[i++]) {
+                case '"': out += '"'; break;
+                case '\\': out += '\\'; break;
+                case '/': out += '/'; break;
+                case 'b': out += '\b'; break;
+                case 'f': out += '\f'; break;
+                case 'n': out += '\n'; break;
+                case 'r': out += '\r'; break;
+                case 't': out += '\t'; break;
+                case 'u': {
+                    uint32_t cp;
+                    if (!hex4(cp)) return false;
+                    // A high surrogate must pair with a low one
+                    if (cp >= 0xd800 && cp < 0xdc00) {
+                        uint32_t low;
+                        if (i + 1 >= s.size() || s[i] != '\\' || s[i + 1] != 'u') return false;
+                        i += 2;
+                        if (!hex4(low) || low < 0xdc00 || low >= 0xe000) return false;
+                        cp = 0x10000 + ((cp - 0xd800) << 10) + (low - 0xdc00);
+                    } else if (cp >= 0xdc00 && cp < 0xe000) {
+                        return false;
+                    }
+                    appendUtf8(out, cp);
+                    break;
+                }
+                default: return false;
+            }
+        }
+        return false;
+    }
+
+    // A number, true, false or null, as written.
+    bool scalar(string& out) {
+        ws();
+        size_t start = i;
+        while (i < s.size() && s[i] != ',' && s[i] != '}' && s[i] != ']' && s[i] != ' ' && s[i] != '\t') i++;
+        out.assign(s.substr(start, i - start));
+        return i > start;
+    }
+
+    // Any value, nested ones included.
+    bool skip() {
+        ws();
+        if (i >= s.size()) return false;
+        string scratch;
+        if (s[i] == '"') return str(scratch);
+        if (s[i] != '{' && s[i] != '[') return scalar(scratch);
+        char open = s[i++], close = open == '{' ? '}' : ']';
+        if (eat(close)) return true;
+        do {
+            if (open == '{' && (!str(scratch) || !eat(':'))) return false;
+            if (!skip()) return false;
+        } while (eat(','));
+        return eat(close);
+    }
+
+    bool isString() {
+        ws();
+        return i < s.size() && s[i] == '"';
+    }
+
+private:
+    string_view s;
+    size_t i = 0;
+
+    bool hex4(uint32_t& out) {
+        if (i + 4 > s.size()) return false;
+        auto r = from_chars(s.data() + i, s.data() + i + 4, out, 16);
+        if (r.ec != errc() || r.ptr != s.data() + i + 4) return false;
+        i += 4;
+        return true;
+    }
+};
+
+static const char* parseJson(string_view line, Row& row) {
+    JsonCursor in(line);
+    if (!in.eat('{')) return "not a JSON object";
+    enum { ID, NAME, QUANTITY, PRICE, FIELDS };
+    string key, values[FIELDS];
+    bool has[FIELDS] = {};
+    if (!in.eat('}')) {
+        do {
+            if (!in.str(key) || !in.eat(':')) return "bad JSON";
+            int field = key == "id" || key == "item_id"     ? ID
+                        : key == "name"                     ? NAME
+                        : key == "quantity" || key == "qty" ? QUANTITY
+                        : key == "price"                    ? PRICE
+                                                            : FIELDS;
+            if (field == FIELDS) {
+                if (!in.skip()) return "bad JSON";
+                continue;
+            }
+            if (!(in.isString() ? in.str(values[field]) : in.scalar(values[field]))) return "bad JSON";
+            has[field] = true;
+        } while (in.eat(','));
+        if (!in.eat('}')) return "bad JSON";
+    }
+    if (!in.atEnd()) return "text after the object";
+    if (!has[ID]) return "missing id";
+    if (!has[NAME]) return "missing name";
+    if (!has[QUANTITY]) return "missing quantity";
+    if (!has[PRICE]) return "missing price";
+    return validate(trim(values[ID]), values[NAME], trim(values[QUANTITY]), trim(values[PRICE]), row);
+}
+
+static bool blank(string_view line) {
+    return all_of(line.begin(), line.end(), [](char c) { return c == ' ' || c == '\t'; });
+}
+
+static void parsePart(Part& part, Format format, const Columns& cols) {
+    vector<string> fields;
+    size_t pos = 0;
+    while (pos < part.text.size()) {
+        size_t end = min(part.text.find('\n', pos), part.text.size());
+        string_view line = part.text.substr(pos, end - pos);
+        pos = end + 1;
+        part.lines++;
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (blank(line)) continue;
+        Row row;
+        row.line = part.lines;
+        row.error = format == Format::CSV ? parseCsv(line, cols, fields, row) : parseJson(line, row);
+        part.rows.push_back(move(row));
+    }
+}
+
+// Cuts text into up to n parts of about equal size, each ending at a newline.
+static vector<Part> splitParts(string_view text, size_t n) {
+    vector<Part> parts;
+    size_t pos = 0;
+    for (size_t p = 0; p < n && pos < text.size(); p++) {
+        size_t end = p + 1 == n ? text.size() : pos + (text.size() - pos) / (n - p);
+        if (end < text.size()) end = min(text.find('\n', end), text.size() - 1) + 1;
+        parts.push_back({text.substr(pos, end - pos), {}, 0});
+        pos = end;
+    }
+    return parts;
+}
+
+// Reads the CSV header if the first line is one, which it is when any field
+// names a known column; otherwise the line is left to be parsed as data.
+// False if it is a header that lacks a column we need.
+static bool readHeader(string_view& text, size_t& lines, Columns& cols) {
+    while (!text.empty()) {
+        size_t end = min(text.find('\n', 0), text.size());
+        string_view line = text.substr(0, end);
+        if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+        if (blank(line)) {
+            text.remove_prefix(min(end + 1, text.size()));
+            lines++;
+            continue;
+        }
+        vector<string> fields;
+        if (!splitCsv(line, fields)) return true;
+
+        const size_t NONE = SIZE_MAX;
+        size_t id = NONE, name = NONE, quantity = NONE, price = NONE;
+        bool known = false;
+        for (size_t i = 0; i < fields.size(); i++) {
+            string f = fields[i];
+            for (char& c : f) c = (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : c;
+            if (f == "id" || f == "item_id") id = i;
+            else if (f == "name") name = i;
+            else if (f == "quantity" || f == "qty") quantity = i;
+            else if (f == "price") price = i;
+            else continue;
+            known = true;
+        }
+        if (!known) return true;
+        if (id == NONE || name == NONE || quantity == NONE || price == NONE) return false;
+        cols = {id, name, quantity, price};
+        text.remove_prefix(min(end + 1, text.size()));
+        lines++;
+        return true;
+    }
+    return true;
+}
+
+static void noteError(ImportReport& report, const ImportOptions& options, size_t line, const string& what) {
+    if (report.errors.size() < options.maxErrors) report.errors.push_back("line " + to_string(line) + ": " + what);
+}
+
+// Applies one batch under one exclusive lock and one journal commit.
+static market::Status applyBatch(AppState& state, store::Journal& journal, int sellerId, const vector<Row>& batch,
+                                 ImportReport& report) {
+    Exclusive lock(state.structure);
+    seller* s = state.findSeller(sellerId);
+    if (!s) return market::NOT_A_SELLER;
+    vector<Catalog::NewRow> fresh;
+    for (const Row& r : batch) {
+        if (state.updateItem(sellerId, r.itemId, r.name, r.quantity, r.price)) {
+            journal.itemUpdated(sellerId, state.findItem(sellerId, r.itemId));
+            report.updated++;
+        } else {
+            fresh.push_back({r.itemId, symbols::intern(r.name), r.quantity, r.price});
+        }
+    }
+    size_t first = state.addItems(*s, fresh);
+    for (size_t i = 0; i < fresh.size(); i++) journal.itemAdded(sellerId, Item(state.catalog, first + i));
+    report.added += fresh.size();
+    report.batches++;
+    journal.commit();
+    return market::OK;
+}
+
+market::Status importCatalog(AppState& state, store::Journal& journal, int sellerId, const string& path,
+                             Format format, ImportReport& report, const ImportOptions& options) {
+    Clock::time_point start = Clock::now();
+    report = ImportReport();
+    {
+        Shared lock(state.structure);
+        if (!state.findSeller(sellerId)) return market::NOT_A_SELLER;
+    }
+    ifstream in(path, ios::binary);
+    if (!in) return market::NOT_FOUND;
+
+    size_t threads = options.threads ? options.threads : max(1u, thread::hardware_concurrency());
+    size_t chunk = max<size_t>(options.chunkBytes, 1);
+    size_t batchRows = max<size_t>(options.batchRows, 1);
+    Columns cols;
+    unordered_set<int> seen;
+    vector<Row> batch;
+    batch.reserve(batchRows);
+    market::Status status = market::OK;
+    size_t lineBase = 0;
+    bool first = true;
+    string block;
+
+    while (status == market::OK) {
+        size_t kept = block.size();
+        block.resize(kept + chunk);
+        in.read(&block[kept], static_cast<streamsize>(chunk));
+        block.resize(kept + static_cast<size_t>(in.gcount()));
+        bool eof = !in;
+        // Only whole lines now; a partial last line waits for the next read
+        size_t cut = eof ? block.size() : block.rfind('\n') + 1;
+        if (cut == 0 && !eof) continue;
+        string_view text(block.data(), cut);
+
+        if (first) {
+            if (text.substr(0, 3) == "\xEF\xBB\xBF") text.remove_prefix(3);
+            if (format == Format::CSV && !readHeader(text, lineBase, cols)) {
+                status = market::INVALID;
+                break;
+            }
+            first = false;
+        }
+
+        // Small chunks are not worth the threads
+        vector<Part> parts = splitParts(text, text.size() < (64 << 10) ? 1 : threads);
+        vector<std::thread> workers;
+        for (size_t p = 1; p < parts.size(); p++) workers.emplace_back(parsePart, std::ref(parts[p]), format, std::cref(cols));
+        if (!parts.empty()) parsePart(parts[0], format, cols);
+        for (auto& w : workers) w.join();
+
+        for (Part& part : parts) {
+            for (Row& row : part.rows) {
+                row.line += lineBase;
+                report.rows++;
+                if (row.error) {
+                    report.rejected++;
+                    noteError(report, options, row.line, row.error);
+                } else if (!seen.insert(row.itemId).second) {
+                    report.duplicates++;
+                    noteError(report, options, row.line, "duplicate item id " + to_string(row.itemId));
+                } else {
+                    batch.push_back(move(row));
+                    if (batch.size() == batchRows) {
+                        status = applyBatch(state, journal, sellerId, batch, report);
+                        batch.clear();
+                        if (status != market::OK) break;
+                    }
+                }
+            }
+            lineBase += part.lines;
+            if (status != market::OK) break;
+        }
+        block.erase(0, cut);
+        if (eof) break;
+    }
+    if (status == market::OK && !batch.empty()) status = applyBatch(state, journal, sellerId, batch, report);
+    // Once for the whole import rather than after every batch
+    if (report.batches) market::compactIfNeeded(state, journal);
+    report.seconds = chrono::duration<double>(Clock::now() - start).count();
+    return status;
+}
+
+static void csvField(string& out, string_view s) {
+    bool quote = s.find_first_of(",\"") != string_view::npos || trim(s).size() != s.size();
+    if (!quote) {
+        out += s;
+        return;
+    }
+    out += '"';
+    for (char c : s) {
+        if (c == '"') out += '"';
+        out += c;
+    }
+    out += '"';
+}
+
+static void jsonString(string& out, string_view s) {
+    static const char HEX[] = "0123456789abcdef";
+    out += '"';
+    for (char c : s) {
+        unsigned char u = static_cast<unsigned char>(c);
+        if (c == '"' || c == '\\') {
+            out += '\\';
+            out += c;
+        } else if (u < 0x20) {
+            out += "\\u00";
+            out += HEX[u >> 4];
+            out += HEX[u & 0xf];
+        } else {
+            out += c;
+        }
+    }
+    out += '"';
+}
+
+market::Status exportCatalog(const AppState& state, int sellerId, const string& path, Format format, ExportReport& report) {
+    Clock::time_point start = Clock::now();
+    report = ExportReport();
+    // Written beside the target and renamed over it, so an export that fails
+    // leaves whatever file was there untouched
+    string tmp = path + ".tmp";
+    ofstream out;
+
+    const size_t FLUSH_AT = 1 << 20;
+    string buf;
+    buf.reserve(FLUSH_AT + 4096);
+    if (format == Format::CSV) buf += "id,name,quantity,price\n";
+    char number[Money::MAX_CHARS];
+    {
+        // Shared: sessions keep trading, only catalog edits wait
+        Shared lock(state.structure);
+        if (!state.sellerHandle(sellerId)) return market::NOT_A_SELLER;
+        out.open(tmp, ios::binary | ios::trunc);
+        if (!out) return market::NOT_FOUND;
+        const Catalog& c = state.catalog;
+        Catalog::Range r = c.rangeOf(sellerId);
+        for (size_t row = r.begin; row < r.end; row++) {
+            string_view price(number, c.price(row).format(number));
+            if (format == Format::CSV) {
+                buf += to_string(c.itemId(row));
+                buf += ',';
+                csvField(buf, c.name(row));
+                buf += ',';
+                buf += to_string(c.quantity(row));
+                buf += ',';
+                buf += price;
+            } else {
+                buf += "{\"id\":";
+                buf += to_string(c.itemId(row));
+                buf += ",\"name\":";
+                jsonString(buf, c.name(row));
+                buf += ",\"quantity\":";
+                buf += to_string(c.quantity(row));
+                buf += ",\"price\":";
+                buf += price;
+                buf += '}';
+            }
+            buf += '\n';
+            report.rows++;
+            if (buf.size() >= FLUSH_AT) {
+                out.write(buf.data(), static_cast<streamsize>(buf.size()));
+                buf.clear();
+            }
+        }
+    }
+    out.write(buf.data(), static_cast<streamsize>(buf.size()));
+    out.close();
+    bool ok = out && store::replace_file(tmp, path);
+    if (!ok) {
+        error_code ec;
+        filesystem::remove(tmp, ec);
+    }
+    report.seconds = chrono::duration<double>(Clock::now() - start).count();
+    return ok ? market::OK : market::NOT_FOUND;
+}
+
+}
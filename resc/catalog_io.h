@@ -0,0 +1,73 @@
+#ifndef CATALOG_IO_H
+#define CATALOG_IO_H
+
+#include <cstddef>
+#include <string>
+#include <vector>
+#include "app_state.h"
+#include "journal.h"
+#include "market.h"
+
+using namespace std;
+
+// Bulk import and export of one seller's catalog as CSV or NDJSON.
+//
+// CSV rows are id,name,quantity,price, or any order given by a header line
+// naming those columns (item_id and qty are accepted too). Fields may be
+// double-quoted, with "" for a quote. NDJSON rows are flat objects with the
+// same keys; price may be a number or a string. Either way one record is
+// one line.
+//
+// The file is read in chunks and each chunk is parsed on several threads;
+// rows are then applied in file order in batches, each under one exclusive
+// lock and one journal commit. An id the seller already has is updated in
+// place, and an id repeated within the file keeps its first row.
+namespace catalog_io {
+
+enum class Format { CSV, NDJSON };
+
+// From the extension: .csv, or .ndjson/.jsonl/.json. False if neither.
+bool formatFor(const string& path, Format& out);
+const char* formatName(Format format);
+
+struct ImportOptions {
+    size_t batchRows = 10000;
+    size_t chunkBytes = 8 << 20;
+    unsigned threads = 0;          // 0: one per hardware thread
+    size_t maxErrors = 20;         // error messages kept in the report
+};
+
+struct ImportReport {
+    size_t rows = 0;               // records read, valid or not
+    size_t added = 0;
+    size_t updated = 0;
+    size_t duplicates = 0;         // ids seen earlier in the file
+    size_t rejected = 0;           // failed validation
+    size_t batches = 0;
+    double seconds = 0;
+    vector<string> errors;         // "line N: reason", first maxErrors only
+
+    double rowsPerSecond() const { return seconds > 0 ? static_cast<double>(rows) / seconds : 0; }
+};
+
+// NOT_A_SELLER if there is no such seller, NOT_FOUND if the file cannot be
+// read, INVALID if a CSV header lacks one of the four columns.
+market::Status importCatalog(AppState& state, store::Journal& journal, int sellerId, const string& path,
+                             Format format, ImportReport& report, const ImportOptions& options = {});
+
+struct ExportReport {
+    size_t rows = 0;
+    double seconds = 0;
+
+    double rowsPerSecond() const { return seconds > 0 ? static_cast<double>(rows) / seconds : 0; }
+};
+
+// Writes the seller's items in catalog order, with a header line for CSV,
+// in a form importCatalog reads back unchanged. The file is replaced only
+// once the export is complete; NOT_A_SELLER or NOT_FOUND (cannot be
+// written) leave an existing file as it was.
+market::Status exportCatalog(const AppState& state, int sellerId, const string& path, Format format, ExportReport& report);
+
+}
+
+#endif // CATALOG_IO_H
@@ -0,0 +1,173 @@
+#include "catalog_query.h"
+#include <algorithm>
+
+#if defined(__GNUC__) && (defined(__x86_64__) || defined(__i386__))
+#define CATALOG_QUERY_X86 1
+#include <immintrin.h>
+#endif
+
+using namespace std;
+
+namespace query {
+
+namespace {
+
+struct Bounds {
+    int64_t minPrice, maxPrice;
+    int32_t minQuantity, maxQuantity;
+    Visibility visibility;
+};
+
+struct Columns {
+    const int32_t* quantity;
+    const int64_t* price;
+    const uint64_t* visible;
+};
+
+using Kernel = void (*)(const Columns&, const Bounds&, size_t, size_t, Selection&);
+
+// Visibility bits of rows [row, row + n), n <= 32, as bit 0..n-1.
+inline uint32_t visibleBits(const uint64_t* visible, size_t row, unsigned n) {
+    size_t word = row / 64;
+    unsigned shift = static_cast<unsigned>(row % 64);
+    uint64_t bits = visible[word] >> shift;
+    if (shift + n > 64) bits |= visible[word + 1] << (64 - shift);
+    return static_cast<uint32_t>(bits) & ((uint32_t(1) << n) - 1);
+}
+
+// Narrows a block mask by the visibility predicate.
+inline uint32_t withVisibility(uint32_t mask, const Columns& c, const Bounds& b, size_t row, unsigned n) {
+    if (b.visibility == Visibility::ANY) return mask;
+    uint32_t bits = visibleBits(c.visible, row, n);
+    return mask & (b.visibility == Visibility::VISIBLE ? bits : ~bits);
+}
+
+void scanScalar(const Columns& c, const Bounds& b, size_t begin, size_t end, Selection& out) {
+    for (size_t r = begin; r < end; r++) {
+        int32_t q = c.quantity[r];
+        int64_t p = c.price[r];
+        if (q < b.minQuantity || q > b.maxQuantity || p < b.minPrice || p > b.maxPrice) continue;
+        if (withVisibility(1, c, b, r, 1)) out.push_back(static_cast<uint32_t>(r));
+    }
+}
+
+#ifdef CATALOG_QUERY_X86
+
+inline void emit(uint32_t mask, size_t row, Selection& out) {
+    while (mask) {
+        out.push_back(static_cast<uint32_t>(row + static_cast<size_t>(__builtin_ctz(mask))));
+        mask &= mask - 1;
+    }
+}
+
+// 8 rows per step: one 8 x i32 compare for quantity, two 4 x i64 for price.
+__attribute__((target("avx2")))
+void scanAvx2(const Columns& c, const Bounds& b, size_t begin, size_t end, Selection& out) {
+    const __m256i minQ = _mm256_set1_epi32(b.minQuantity), maxQ = _mm256_set1_epi32(b.maxQuantity);
+    const __m256i minP = _mm256_set1_epi64x(b.minPrice), maxP = _mm256_set1_epi64x(b.maxPrice);
+    size_t r = begin;
+    for (; r + 8 <= end; r += 8) {
+        __m256i q = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c.quantity + r));
+        __m256i qOut = _mm256_or_si256(_mm256_cmpgt_epi32(minQ, q), _mm256_cmpgt_epi32(q, maxQ));
+        uint32_t mask = ~static_cast<uint32_t>(_mm256_movemask_ps(_mm256_castsi256_ps(qOut))) & 0xFF;
+        if (!mask) continue;
+        __m256i p0 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c.price + r));
+        __m256i p1 = _mm256_loadu_si256(reinterpret_cast<const __m256i*>(c.price + r + 4));
+        __m256i pOut0 = _mm256_or_si256(_mm256_cmpgt_epi64(minP, p0), _mm256_cmpgt_epi64(p0, maxP));
+        __m256i pOut1 = _mm256_or_si256(_mm256_cmpgt_epi64(minP, p1), _mm256_cmpgt_epi64(p1, maxP));
+        uint32_t pOut = static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(pOut0))) |
+                        static_cast<uint32_t>(_mm256_movemask_pd(_mm256_castsi256_pd(pOut1))) << 4;
+        emit(withVisibility(mask & ~pOut, c, b, r, 8), r, out);
+    }
+    scanScalar(c, b, r, end, out);
+}
+
+// 4 rows per step; 64-bit compares need SSE4.2.
+__attribute__((target("sse4.2")))
+void scanSse42(const Columns& c, const Bounds& b, size_t begin, size_t end, Selection& out) {
+    const __m128i minQ = _mm_set1_epi32(b.minQuantity), maxQ = _mm_set1_epi32(b.maxQuantity);
+    const __m128i minP = _mm_set1_epi64x(b.minPrice), maxP = _mm_set1_epi64x(b.maxPrice);
+    size_t r = begin;
+    for (; r + 4 <= end; r += 4) {
+        __m128i q = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c.quantity + r));
+        __m128i qOut = _mm_or_si128(_mm_cmpgt_epi32(minQ, q), _mm_cmpgt_epi32(q, maxQ));
+        uint32_t mask = ~static_cast<uint32_t>(_mm_movemask_ps(_mm_castsi128_ps(qOut))) & 0xF;
+        if (!mask) continue;
+        __m128i p0 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c.price + r));
+        __m128i p1 = _mm_loadu_si128(reinterpret_cast<const __m128i*>(c.price + r + 2));
+        __m128i pOut0 = _mm_or_si128(_mm_cmpgt_epi64(minP, p0), _mm_cmpgt_epi64(p0, maxP));
+        __m128i pOut1 = _mm_or_si128(_mm_cmpgt_epi64(minP, p1), _mm_cmpgt_epi64(p1, maxP));
+        uint32_t pOut = static_cast<uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(pOut0))) |
+                        static_cast<uint32_t>(_mm_movemask_pd(_mm_castsi128_pd(pOut1))) << 2;
+        emit(withVisibility(mask & ~pOut, c, b, r, 4), r, out);
+    }
+    scanScalar(c, b, r, end, out);
+}
+
+#endif
+
+struct Choice {
+    Kernel kernel;
+    const char* name;
+};
+
+Choice pick() {
+#ifdef CATALOG_QUERY_X86
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2")) return {scanAvx2, "avx2"};
+    if (__builtin_cpu_supports("sse4.2")) return {scanSse42, "sse4.2"};
+#endif
+    return {scanScalar, "scalar"};
+}
+
+const Choice& chosen() {
+    static const Choice choice = pick();
+    return choice;
+}
+
+}
+
+// Appends matches in rows [begin, end) to out.
+static void scan(const Catalog& catalog, const ItemFilter& filter, size_t begin, size_t end, Selection& out) {
+    Columns c{catalog.quantityColumn().data(), catalog.priceColumn().data(), catalog.visibleBitmap().data()};
+    Bounds b{filter.minPrice.cents(), filter.maxPrice.cents(), filter.minQuantity, filter.maxQuantity, filter.visibility};
+    chosen().kernel(c, b, begin, end, out);
+}
+
+Selection select(const Catalog& catalog, const ItemFilter& filter, Catalog::Range rows) {
+    Selection out;
+    size_t end = min<size_t>(rows.end, catalog.size());
+    if (rows.begin < end) scan(catalog, filter, rows.begin, end, out);
+    return out;
+}
+
+Selection select(const Catalog& catalog, const ItemFilter& filter) {
+    return select(catalog, filter, Catalog::Range{0, static_cast<uint32_t>(catalog.size())});
+}
+
+vector<int> sellersWith(const Catalog& catalog, const ItemFilter& filter) {
+    vector<int> sellers;
+    Selection hits;
+    // Seller by seller, in growing chunks, so a seller whose first items
+    // match costs a few blocks rather than a scan of all its rows
+    size_t row = 0;
+    while (row < catalog.size()) {
+        int id = catalog.sellerId(row);
+        size_t end = catalog.rangeOf(id).end;
+        for (size_t chunk = 64; row < end && hits.empty(); chunk = min<size_t>(chunk * 2, 4096)) {
+            size_t stop = min(end, row + chunk);
+            scan(catalog, filter, row, stop, hits);
+            row = stop;
+        }
+        if (!hits.empty()) sellers.push_back(id);
+        hits.clear();
+        row = end;
+    }
+    return sellers;
+}
+
+const char* kernelName() {
+    return chosen().name;
+}
+
+}
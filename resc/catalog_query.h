@@ -0,0 +1,46 @@
+#ifndef CATALOG_QUERY_H
+#define CATALOG_QUERY_H
+
+#include <cstdint>
+#include <limits>
+#include <vector>
+#include "catalog.h"
+#include "money.h"
+
+using namespace std;
+
+// Filters over the whole Catalog, evaluated a block of rows at a time on the
+// price, quantity and visibility columns. On x86-64 the kernel is picked at
+// startup: AVX2, then SSE4.2, else a scalar loop giving the same results.
+//
+// Callers hold AppState::structure (shared is enough). Stock can move while
+// a scan runs, so each row is tested against whatever count it had then.
+namespace query {
+
+enum class Visibility { ANY, VISIBLE, HIDDEN };
+
+// Every bound is inclusive.
+struct ItemFilter {
+    Money minPrice = Money::fromCents(numeric_limits<int64_t>::min());
+    Money maxPrice = Money::fromCents(numeric_limits<int64_t>::max());
+    int minQuantity = numeric_limits<int>::min();
+    int maxQuantity = numeric_limits<int>::max();
+    Visibility visibility = Visibility::ANY;
+};
+
+// Catalog rows, ascending. Rows of one seller are adjacent.
+using Selection = vector<uint32_t>;
+
+// Rows in [rows.begin, rows.end) matching the filter, e.g. one seller's range.
+Selection select(const Catalog& catalog, const ItemFilter& filter, Catalog::Range rows);
+// Rows of the whole catalog matching the filter.
+Selection select(const Catalog& catalog, const ItemFilter& filter);
+// Sellers with at least one matching row, in catalog order.
+vector<int> sellersWith(const Catalog& catalog, const ItemFilter& filter);
+
+// Name of the kernel in use: "avx2", "sse4.2" or "scalar".
+const char* kernelName();
+
+}
+
+#endif // CATALOG_QUERY_H
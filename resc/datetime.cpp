@@ -1,44 +1,102 @@
 #include "datetime.h"
-#include <iomanip>
-#include <sstream>
+#include <atomic>
 
 namespace dt {
 
-static std::tm parse(const std::string &s) {
-    std::tm tm{};
-    std::istringstream iss(s);
-    iss >> std::get_time(&tm, "%Y-%m-%d");
-    return tm;
+static_assert(days_from_civil(1970, 1, 1) == 0);
+static_assert(days_from_civil(2000, 3, 1) == 11017);
+static_assert(civil_from_days(11017).year == 2000 && civil_from_days(11017).month == 3);
+static_assert(civil_from_days(days_from_civil(2024, 2, 29)).day == 29);
+
+static constexpr bool leap(int y) {
+    return y % 4 == 0 && (y % 100 != 0 || y % 400 == 0);
 }
 
-static std::string format(const std::tm &tm) {
-    std::ostringstream oss;
-    oss << std::put_time(&tm, "%Y-%m-%d");
-    return oss.str();
+static constexpr unsigned days_in_month(int y, unsigned m) {
+    constexpr unsigned char len[] = {31, 28, 31, 30, 31, 30, 31, 31, 30, 31, 30, 31};
+    return m == 2 && leap(y) ? 29 : len[m - 1];
 }
 
-std::string today() {
+// Reads 1 to `max` digits at s[pos], advancing pos.
+static bool digits(std::string_view s, size_t &pos, size_t max, unsigned &out) {
+    size_t start = pos;
+    out = 0;
+    while (pos < s.size() && pos - start < max && s[pos] >= '0' && s[pos] <= '9') {
+        out = out * 10 + static_cast<unsigned>(s[pos++] - '0');
+    }
+    return pos > start;
+}
+
+bool parse(std::string_view s, Day &out) {
+    size_t pos = 0;
+    unsigned y, m, d;
+    if (!digits(s, pos, 4, y) || pos != 4 || pos >= s.size() || s[pos++] != '-') return false;
+    if (!digits(s, pos, 2, m) || pos >= s.size() || s[pos++] != '-') return false;
+    if (!digits(s, pos, 2, d) || pos != s.size()) return false;
+    int year = static_cast<int>(y);
+    if (m < 1 || m > 12 || d < 1 || d > days_in_month(year, m)) return false;
+    out = days_from_civil(year, m, d);
+    return true;
+}
+
+Day from_string(std::string_view s) {
+    Day d = NO_DAY;
+    return parse(s, d) ? d : NO_DAY;
+}
+
+size_t format(Day d, char (&buf)[16]) {
+    buf[0] = '\0';
+    if (d == NO_DAY) return 0;
+    Civil c = civil_from_days(d);
+    if (c.year < 0 || c.year > 9999) return 0;
+    unsigned y = static_cast<unsigned>(c.year);
+    const unsigned parts[] = {y / 1000, y / 100 % 10, y / 10 % 10, y % 10, 10,
+                              c.month / 10, c.month % 10, 10, c.day / 10, c.day % 10};
+    size_t n = 0;
+    for (unsigned p : parts) buf[n++] = p == 10 ? '-' : static_cast<char>('0' + p);
+    buf[n] = '\0';
+    return n;
+}
+
+std::string format(Day d) {
+    char buf[16];
+    size_t n = format(d, buf);
+    return std::string(buf, n);
+}
+
+// The cached day in the low half, the minute it must be recomputed at in
+// the high half; one word, so a reader never pairs a day with another's expiry.
+static std::atomic<uint64_t> cached{0};
+
+Day current_day() {
     std::time_t t = std::time(nullptr);
+    uint64_t minute = static_cast<uint64_t>(t) / 60;
+    uint64_t c = cached.load(std::memory_order_relaxed);
+    if (minute < (c >> 32)) return static_cast<Day>(static_cast<uint32_t>(c));
+
     std::tm tm{};
 #if defined(_WIN32)
     localtime_s(&tm, &t);
 #else
-    tm = *std::localtime(&t);
+    localtime_r(&t, &tm);  // std::localtime shares one buffer across threads
 #endif
-    return format(tm);
+    Day day = days_from_civil(tm.tm_year + 1900, static_cast<unsigned>(tm.tm_mon + 1), static_cast<unsigned>(tm.tm_mday));
+    uint64_t until = minute + 60 - static_cast<uint64_t>(tm.tm_min);
+    cached.store((until << 32) | static_cast<uint32_t>(day), std::memory_order_relaxed);
+    return day;
+}
+
+bool in_last_n_days(Day d, int n) {
+    return in_last_n_days(d, n, current_day());
+}
+
+std::string today() {
+    return format(current_day());
 }
 
 std::string add_days(const std::string &yyyy_mm_dd, int n) {
-    std::tm tm = parse(yyyy_mm_dd);
-    std::time_t tt = std::mktime(&tm);
-    tt += static_cast<long long>(n) * 24 * 60 * 60;
-#if defined(_WIN32)
-    std::tm out{};
-    localtime_s(&out, &tt);
-    return format(out);
-#else
-    return format(*std::localtime(&tt));
-#endif
+    Day d = from_string(yyyy_mm_dd);
+    return d == NO_DAY ? std::string() : format(d + n);
 }
 
 int compare(const std::string &a, const std::string &b) {
@@ -51,9 +109,8 @@ bool same_day(const std::string &a, const std::string &b) {
 }
 
 bool in_last_n_days(const std::string &d, int n, const std::string &ref) {
-    std::string r = ref.empty() ? today() : ref;
-    std::string from = add_days(r, -(n - 1));
-    return compare(d, from) >= 0 && compare(d, r) <= 0;
+    Day day = from_string(d);
+    return day != NO_DAY && in_last_n_days(day, n, ref.empty() ? current_day() : from_string(ref));
 }
 
 bool in_last_month(const std::string &d, const std::string &ref) {
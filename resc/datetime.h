@@ -1,20 +1,74 @@
 #ifndef DATETIME_H
 #define DATETIME_H
 
+#include <cstdint>
+#include <climits>
 #include <string>
+#include <string_view>
 #include <ctime>
 
 
 namespace dt {
 
+using namespace std;
+
+// A calendar date as days since 1970-01-01 (proleptic Gregorian), so
+// comparing or stepping dates is integer arithmetic.
+using Day = int32_t;
+// No date: an unparseable or missing one. Sorts before every real date.
+constexpr Day NO_DAY = INT32_MIN;
 
+struct Civil {
+    int year;
+    unsigned month;   // 1-12
+    unsigned day;     // 1-31
+};
 
+// Howard Hinnant's days_from_civil / civil_from_days.
+constexpr Day days_from_civil(int y, unsigned m, unsigned d) {
+    y -= m <= 2;
+    const int era = (y >= 0 ? y : y - 399) / 400;
+    const unsigned yoe = static_cast<unsigned>(y - era * 400);
+    const unsigned doy = (153 * (m > 2 ? m - 3 : m + 9) + 2) / 5 + d - 1;
+    const unsigned doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + static_cast<int>(doe) - 719468;
+}
 
+constexpr Civil civil_from_days(Day z) {
+    z += 719468;
+    const int era = (z >= 0 ? z : z - 146096) / 146097;
+    const unsigned doe = static_cast<unsigned>(z - era * 146097);
+    const unsigned yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    const int y = static_cast<int>(yoe) + era * 400;
+    const unsigned doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    const unsigned mp = (5 * doy + 2) / 153;
+    const unsigned d = doy - (153 * mp + 2) / 5 + 1;
+    const unsigned m = mp < 10 ? mp + 3 : mp - 9;
+    return {y + (m <= 2), m, d};
+}
 
+// Reads YYYY-MM-DD (month and day may be one digit); false unless it names
+// a real date.
+bool parse(string_view s, Day &out);
+// NO_DAY if `s` is not a date.
+Day from_string(string_view s);
+// YYYY-MM-DD into buf, NUL-terminated; returns the length, 0 for NO_DAY.
+// Uses no locale or shared buffer, so any thread may call it.
+size_t format(Day d, char (&buf)[16]);
+string format(Day d);
 
+// The local date. Cached until the next local hour, so it is cheap enough to
+// call per request and still follows midnight and DST changes.
+Day current_day();
 
-using namespace std;
+// The n days ending at ref, ref included.
+constexpr bool in_last_n_days(Day d, int n, Day ref) {
+    return d <= ref && int64_t(ref) - d < n;
+}
+// `ref` defaults to the current day.
+bool in_last_n_days(Day d, int n);
 
+// String forms of the above, for callers holding YYYY-MM-DD text.
 string today();
 string add_days(const string &yyyy_mm_dd, int n);
 int compare(const string &a, const string &b);
@@ -24,4 +78,4 @@ bool in_last_month(const string &d, const string &ref = "");
 
 }
 
-#endif // DATETIME_H
\ No newline at end of file
+#endif // DATETIME_H
@@ -1,50 +1,80 @@
 #ifndef ITEM_H
 #define ITEM_H
 
-#include <string>
-
-using namespace std;
+#include <cstddef>
+#include <iterator>
+#include <string_view>
+#include "catalog.h"
+#include "money.h"
 
 using namespace std;
 
+// One row of the Catalog. It is a small handle, cheap to copy, and valid
+// until the next row is added to or erased from the catalog. Stock is split
+// into what buyers can still order (quantity) and what pending orders hold
+// (reserved); see tryReserve/release/consume.
 class Item {
 private:
-    int id;
-    string name;
-    int quantity;
-    double price;
-    bool idDisplay;
+    Catalog* catalog = nullptr;
+    size_t row = 0;
 public:
-    Item(int id, const string& name, int quantity, double price)
-        : id(id), name(name), quantity(quantity), price(price) {
-            idDisplay = false;
-        }
-    int getId() const { return id; }
-    const string& getName() const { return name; }
-    int getQuantity() const { return quantity; }
-    double getPrice() const { return price; }
-    Item *getItem() {
-        return this;
-    }
+    Item() = default;
+    Item(Catalog& catalog, size_t row) : catalog(&catalog), row(row) {}
+
+    // False for the empty handle returned when no item matches.
+    explicit operator bool() const { return catalog != nullptr; }
+    size_t getRow() const { return row; }
+
+    int getId() const { return catalog->itemId(row); }
+    int getSellerId() const { return catalog->sellerId(row); }
+    string_view getName() const { return catalog->name(row); }
+    symbols::Id getNameId() const { return catalog->nameId(row); }
+    // Available to order, i.e. not held by a pending order.
+    int getQuantity() const { return catalog->quantity(row); }
+    int getReserved() const { return catalog->reservedQuantity(row); }
+    Money getPrice() const { return catalog->price(row); }
+    bool isDisplayed() const { return catalog->isVisible(row); }
+
+    bool tryReserve(int n) const { return catalog->tryReserve(row, n); }
+    void release(int n) const { catalog->release(row, n); }
+    void consume(int n) const { catalog->consume(row, n); }
+
     // Setters
-    void setId(int newId) { id = newId; }
-    void setName(const string& newName) { name = newName; }
-    void setQuantity(int newQuantity) { quantity = newQuantity; }
-    void setPrice(double newPrice) { price = newPrice; }
-    void setDisplay(bool display) { idDisplay = display; }
-    void alterItemById(int itemId, const string& newName, int newQuantity, double newPrice) {
-        if (id == itemId) {
-            name = newName;
-            quantity = newQuantity;
-            price = newPrice;
-        }
-    }
-    void updatePriceQuantity(int itemId, double newPrice, int newQuantity) {
-        if (id == itemId) {
-            price = newPrice;
-            quantity = newQuantity;
-        }
-    }
+    void setName(string_view newName) const { catalog->setName(row, newName); }
+    void setQuantity(int newQuantity) const { catalog->setQuantity(row, newQuantity); }
+    void setReserved(int newReserved) const { catalog->setReserved(row, newReserved); }
+    void setPrice(Money newPrice) const { catalog->setPrice(row, newPrice); }
+    void setDisplay(bool display) const { catalog->setVisible(row, display); }
+};
+
+// A seller's items, for range-for over Catalog::rangeOf().
+class ItemRange {
+private:
+    Catalog* catalog;
+    Catalog::Range rows;
+public:
+    class iterator {
+        Catalog* catalog;
+        size_t row;
+    public:
+        using iterator_category = forward_iterator_tag;
+        using value_type = Item;
+        using difference_type = ptrdiff_t;
+        using pointer = void;
+        using reference = Item;
+
+        iterator(Catalog* catalog, size_t row) : catalog(catalog), row(row) {}
+        Item operator*() const { return Item(*catalog, row); }
+        iterator& operator++() { ++row; return *this; }
+        bool operator==(const iterator& other) const { return row == other.row; }
+        bool operator!=(const iterator& other) const { return row != other.row; }
+    };
+
+    ItemRange(Catalog& catalog, Catalog::Range rows) : catalog(&catalog), rows(rows) {}
+    iterator begin() const { return iterator(catalog, rows.begin); }
+    iterator end() const { return iterator(catalog, rows.end); }
+    size_t size() const { return rows.size(); }
+    bool empty() const { return rows.empty(); }
 };
 
-#endif // ITEM_H
\ No newline at end of file
+#endif // ITEM_H
@@ -0,0 +1,380 @@
+#include <algorithm>
+#include <charconv>
+#include <fstream>
+#include <sstream>
+#include <stdexcept>
+#include <unordered_map>
+#include <unordered_set>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
+
+#include "journal.h"
+#include "persistence.h"
+
+namespace store {
+
+static bool sync_file(std::FILE *f) {
+    if (std::fflush(f) != 0) return false;
+#if defined(_WIN32)
+    return _commit(_fileno(f)) == 0;
+#else
+    return fsync(fileno(f)) == 0;
+#endif
+}
+
+// The generation a journal's first line names, if it is a JOURNAL_STARTED record.
+static bool journal_generation(const std::string &line, uint64_t &gen) {
+    std::string prefix = std::to_string(JOURNAL_STARTED) + '|';
+    if (line.compare(0, prefix.size(), prefix) != 0) return false;
+    auto r = std::from_chars(line.data() + prefix.size(), line.data() + line.size(), gen);
+    return r.ec == std::errc() && r.ptr == line.data() + line.size();
+}
+
+Journal::Journal(const std::string &path, size_t compactEvery)
+    : dir(path), file(path + "/journal.txt"), out(nullptr), records(0), compactEvery(compactEvery), gen(0) {
+    ensure_data_dir(path);
+    // Count what is already on disk so compaction still triggers across restarts.
+    std::ifstream in(file);
+    std::string line;
+    for (bool first = true; std::getline(in, line); first = false) {
+        if (first && journal_generation(line, gen)) continue;
+        if (!line.empty()) records++;
+    }
+    out = std::fopen(file.c_str(), "a");
+}
+
+Journal::~Journal() {
+    commit();
+    if (background()) {
+        flush();
+        stopping.store(true);
+        wake();
+        worker.join();
+    }
+    if (out) std::fclose(out);
+}
+
+void Journal::startBackground(std::chrono::milliseconds interval, Durability level) {
+    if (background()) return;
+    flushInterval = interval;
+    durability = level;
+    worker = std::thread(&Journal::run, this);
+}
+
+void Journal::wake() {
+    wakeups.fetch_add(1, std::memory_order_release);
+    wakeups.notify_one();
+}
+
+bool Journal::writeLines(const std::vector<std::string> &lines) {
+    if (!out) return false;
+    for (const auto &rec : lines) std::fputs(rec.c_str(), out);
+    return true;
+}
+
+void Journal::run() {
+    unsigned seen = 0;
+    std::vector<std::atomic<bool>*> barriers;
+    while (true) {
+        wakeups.wait(seen, std::memory_order_acquire);
+        seen = wakeups.load(std::memory_order_acquire);
+        // Give a burst of commits time to pile up so they share one sync
+        if (!urgent.exchange(false) && !stopping.load() && flushInterval.count() > 0) {
+            std::this_thread::sleep_for(flushInterval);
+        }
+
+        bool wrote = false;
+        bool ok = true;
+        Batch batch;
+        while (queue.pop(batch)) {
+            if (batch.done) {
+                barriers.push_back(batch.done);
+                continue;
+            }
+            ok &= writeLines(batch.lines);
+            wrote = true;
+        }
+        if (wrote || !barriers.empty()) {
+            ok &= out && (durability == Durability::FSYNC ? sync_file(out) : std::fflush(out) == 0);
+        }
+        if (!ok) failed.store(true);
+        for (auto *done : barriers) {
+            done->store(true, std::memory_order_release);
+            done->notify_all();
+        }
+        barriers.clear();
+
+        if (stopping.load()) return;
+    }
+}
+
+// Records appended by this thread and not yet committed, per journal.
+std::vector<std::string> &Journal::buffered() {
+    thread_local std::unordered_map<const Journal*, std::vector<std::string>> pending;
+    return pending[this];
+}
+
+void Journal::append(RecordType type, const std::string &fields) {
+    buffered().push_back(std::to_string(type) + '|' + fields + '\n');
+}
+
+void Journal::buyerAdded(const Buyer &b) {
+    append(BUYER_ADDED, std::to_string(b.getId()) + '|' + safe(b.getName()) + '|' + safe(b.getEmail()) + '|'
+        + safe(b.getPhone()) + '|' + safe(b.getAddress()));
+}
+
+void Journal::accountOpened(const BankCustomer &acc) {
+    std::ostringstream oss;
+    oss << acc.getId() << '|' << safe(acc.getName()) << '|' << acc.getBalance();
+    append(ACCOUNT_OPENED, oss.str());
+}
+
+void Journal::accountBalance(const BankCustomer &acc) {
+    std::ostringstream oss;
+    oss << acc.getId() << '|' << acc.getBalance();
+    append(ACCOUNT_BALANCE, oss.str());
+}
+
+void Journal::sellerAdded(const seller &s) {
+    append(SELLER_ADDED, std::to_string(s.getUserId()) + '|' + std::to_string(s.getSellerId()) + '|' + safe(s.getStoreName()));
+}
+
+static std::string item_fields(int sellerId, const Item &item) {
+    std::ostringstream oss;
+    oss << sellerId << '|' << item.getId() << '|' << safe(item.getName()) << '|' << item.getQuantity() << '|' << item.getPrice();
+    return oss.str();
+}
+
+void Journal::itemAdded(int sellerId, const Item &item) {
+    append(ITEM_ADDED, item_fields(sellerId, item));
+}
+
+void Journal::itemUpdated(int sellerId, const Item &item) {
+    append(ITEM_UPDATED, item_fields(sellerId, item));
+}
+
+void Journal::itemRemoved(int sellerId, int itemId) {
+    append(ITEM_REMOVED, std::to_string(sellerId) + '|' + std::to_string(itemId));
+}
+
+static void order_header(std::ostringstream &oss, const Transaction &t) {
+    oss << t.getTransactionId() << '|' << t.getBuyerId() << '|' << safe(t.getBuyerName()) << '|'
+        << t.getSellerId() << '|' << safe(t.getSellerName()) << '|'
+        << t.getTotalAmount() << '|' << t.getStatus() << '|' << safe(t.getDate());
+}
+
+void Journal::orderPlaced(const Transaction &t) {
+    std::ostringstream oss;
+    order_header(oss, t);
+    oss << '|' << t.getItems().size();
+    for (const auto &item : t.getItems()) {
+        oss << '|' << item.getItemId() << '|' << safe(item.getItemName()) << '|' << item.getQuantity() << '|' << item.getPricePerUnit();
+    }
+    append(ORDER_RESERVED, oss.str());
+}
+
+void Journal::orderPaid(const Transaction &t) {
+    std::ostringstream oss;
+    order_header(oss, t);
+    append(ORDER_PAID, oss.str());
+}
+
+void Journal::orderCancelled(int transactionId) {
+    append(ORDER_CANCELLED, std::to_string(transactionId));
+}
+
+void Journal::userDeleted(int buyerId) {
+    append(USER_DELETED, std::to_string(buyerId));
+}
+
+bool Journal::commit() {
+    std::vector<std::string> &lines = buffered();
+    if (lines.empty()) return true;
+    records.fetch_add(lines.size(), std::memory_order_relaxed);
+    if (background()) {
+        Batch batch;
+        batch.lines = std::move(lines);
+        lines.clear();
+        queue.push(std::move(batch));
+        wake();
+        return !failed.load();
+    }
+    std::lock_guard<std::mutex> lock(writeLock);
+    bool ok = writeLines(lines);
+    lines.clear();
+    return ok && sync_file(out);
+}
+
+bool Journal::flush() {
+    commit();
+    if (!background()) return out != nullptr;
+    std::atomic<bool> done{false};
+    Batch barrier;
+    barrier.done = &done;
+    queue.push(std::move(barrier));
+    urgent.store(true);
+    wake();
+    done.wait(false, std::memory_order_acquire);
+    return !failed.exchange(false);
+}
+
+bool Journal::reset() {
+    // The worker must not append old records after the truncation
+    flush();
+    std::lock_guard<std::mutex> lock(writeLock);
+    if (out) std::fclose(out);
+    out = std::fopen(file.c_str(), "w");
+    records = 0;
+    if (!out) return false;
+    gen++;
+    std::fputs((std::to_string(JOURNAL_STARTED) + '|' + std::to_string(gen) + '\n').c_str(), out);
+    return sync_file(out);
+}
+
+// Parses an amount column, throwing like std::stoi on bad input; old journals
+// hold plain doubles, which round to the nearest cent.
+static Money to_money(const std::string &text) {
+    Money amount;
+    if (!Money::parse(text, amount)) throw std::invalid_argument("bad amount: " + text);
+    return amount;
+}
+
+// cols[1..8] hold an order header as written by order_header()
+static Transaction &order_from(AppState &state, const std::vector<std::string> &cols) {
+    return state.createOrder(std::stoi(cols[1]), std::stoi(cols[2]), symbols::intern(cols[3]), std::stoi(cols[4]), symbols::intern(cols[5]),
+                             to_money(cols[6]), static_cast<TransactionStatus>(std::stoi(cols[7])), dt::from_string(cols[8]));
+}
+
+size_t Journal::replay(AppState &state, const std::string &path) {
+    std::ifstream f(path + "/journal.txt");
+    size_t applied = 0;
+    std::string line;
+    // Item records set absolute stock, so a journal the snapshot already
+    // includes must not be applied again: it would undo every reservation
+    // made after them. That happens when compaction stops between save_all
+    // and reset().
+    uint64_t gen = 0;
+    if (std::getline(f, line) && !journal_generation(line, gen)) f.seekg(0);
+    if (gen < state.coveredJournals) return 0;
+    // Orders that are no longer pending, so a journal written before
+    // snapshots recorded coveredJournals does not reopen or recount them.
+    std::unordered_set<int> closed;
+    for (const auto &t : state.transactions) closed.insert(t.getTransactionId());
+    while (std::getline(f, line)) {
+        if (f.eof()) break;  // no trailing newline: torn write from a crash
+        std::vector<std::string> cols = split_fields(line);
+        if (cols.size() < 2) continue;
+        int type = std::stoi(cols[0]);
+        switch (type) {
+            case BUYER_ADDED: {
+                if (cols.size() < 6) continue;
+                int id = std::stoi(cols[1]);
+                if (!state.findBuyer(id)) state.addBuyer(id, cols[2], cols[3], cols[4], cols[5], AccountHandle());
+                break;
+            }
+            case ACCOUNT_OPENED: {
+                if (cols.size() < 4) continue;
+                int id = std::stoi(cols[1]);
+                if (!state.findAccount(id)) state.addAccount(id, cols[2], to_money(cols[3]));
+                AccountHandle acc = state.accountHandle(id);
+                if (Buyer *b = state.findBuyer(id)) b->setAccount(acc);
+                state.markDirty(TABLE_BUYERS | TABLE_ACCOUNTS);
+                break;
+            }
+            case ACCOUNT_BALANCE: {
+                if (cols.size() < 3) continue;
+                if (BankCustomer *acc = state.findAccount(std::stoi(cols[1]))) acc->setBalance(to_money(cols[2]));
+                state.markDirty(TABLE_ACCOUNTS);
+                break;
+            }
+            case SELLER_ADDED: {
+                if (cols.size() < 4) continue;
+                int buyerId = std::stoi(cols[1]);
+                int sellerId = std::stoi(cols[2]);
+                if (state.findSeller(sellerId)) break;
+                if (state.findBuyer(buyerId)) state.addSeller(buyerId, sellerId, cols[3]);
+                break;
+            }
+            case ITEM_ADDED:
+            case ITEM_UPDATED: {
+                if (cols.size() < 6) continue;
+                seller *s = state.findSeller(std::stoi(cols[1]));
+                if (!s) break;
+                int itemId = std::stoi(cols[2]);
+                int qty = std::stoi(cols[4]);
+                Money price = to_money(cols[5]);
+                if (!state.updateItem(s->getSellerId(), itemId, cols[3], qty, price)) state.addItem(*s, itemId, cols[3], qty, price);
+                state.markDirty(TABLE_ITEMS);
+                break;
+            }
+            case ITEM_REMOVED: {
+                if (cols.size() < 3) continue;
+                state.removeItem(std::stoi(cols[1]), std::stoi(cols[2]));
+                break;
+            }
+            case ORDER_PLACED:
+            case ORDER_RESERVED: {
+                if (cols.size() < 10) continue;
+                int id = std::stoi(cols[1]);
+                if (closed.count(id) || state.findPendingOrder(id)) break;
+                size_t n = std::stoul(cols[9]);
+                if (cols.size() < 10 + 4 * n) continue;
+                Transaction &t = order_from(state, cols);
+                t.reserveItems(n);
+                for (size_t i = 0; i < n; i++) {
+                    size_t at = 10 + 4 * i;
+                    t.restoreItem(std::stoi(cols[at]), symbols::intern(cols[at + 1]), std::stoi(cols[at + 2]), to_money(cols[at + 3]));
+                }
+                if (type == ORDER_RESERVED) {
+                    for (const auto &line : t.getItems()) {
+                        if (Item item = state.findItem(t.getSellerId(), line.getItemId())) {
+                            item.setQuantity(item.getQuantity() - line.getQuantity());
+                        }
+                    }
+                    state.markDirty(TABLE_ITEMS);
+                }
+                state.addPendingOrder(t);
+                state.markDirty(TABLE_PENDING);
+                break;
+            }
+            case ORDER_PAID: {
+                if (cols.size() < 9) continue;
+                int id = std::stoi(cols[1]);
+                if (!state.closeOrder(id, static_cast<TransactionStatus>(std::stoi(cols[7]))) && !closed.count(id)) {
+                    state.addClosedOrder(order_from(state, cols));
+                }
+                closed.insert(id);
+                state.markDirty(TABLE_TRANSACTIONS | TABLE_PENDING);
+                break;
+            }
+            case ORDER_CANCELLED: {
+                int id = std::stoi(cols[1]);
+                const Transaction *order = state.findPendingOrder(id);
+                if (!order) break;
+                for (const auto &line : order->getItems()) {
+                    if (Item item = state.findItem(order->getSellerId(), line.getItemId())) {
+                        item.setQuantity(item.getQuantity() + line.getQuantity());
+                    }
+                }
+                state.closeOrder(id, CANCELLED);
+                closed.insert(id);
+                state.markDirty(TABLE_ITEMS | TABLE_TRANSACTIONS | TABLE_PENDING);
+                break;
+            }
+            case USER_DELETED: {
+                if (cols.size() < 2) continue;
+                state.removeUser(std::stoi(cols[1]));
+                break;
+            }
+            default:
+                continue;
+        }
+        applied++;
+    }
+    return applied;
+}
+
+}
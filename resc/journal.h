@@ -0,0 +1,129 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <vector>
+#include "mpsc_queue.h"
+#include "buyer.h"
+#include "seller.h"
+#include "item.h"
+#include "bank_customer.h"
+#include "transaction.h"
+
+using namespace std;
+
+struct AppState;
+
+namespace store {
+
+// One line per record in journal.txt: TYPE|fields...
+enum RecordType {
+    BUYER_ADDED,      // id|name|email|phone|address
+    ACCOUNT_OPENED,   // id|name|balance
+    ACCOUNT_BALANCE,  // id|balance (absolute, so replay is idempotent)
+    SELLER_ADDED,     // buyerId|sellerId|storeName
+    ITEM_ADDED,       // sellerId|itemId|name|qty|price
+    ITEM_UPDATED,     // sellerId|itemId|name|qty|price
+    ITEM_REMOVED,     // sellerId|itemId
+    ORDER_PAID,       // id|buyerId|buyerName|sellerId|sellerName|total|status|date
+    USER_DELETED,     // buyerId
+    ORDER_PLACED,     // ORDER_PAID fields|itemCount|(itemId|name|qty|price) * itemCount
+                      //   older journals only; stock came as separate ITEM_UPDATED records
+    ORDER_RESERVED,   // ORDER_PLACED fields; replay also takes the ordered units off stock
+    ORDER_CANCELLED,  // id; replay puts the order's units back on stock
+    JOURNAL_STARTED   // generation; first line of a journal, written by reset()
+};
+
+// How far a group commit goes before it counts as done.
+enum class Durability {
+    WRITE,  // handed to the OS; survives a crash of the process
+    FSYNC   // fsynced; survives a crash of the machine
+};
+
+// Append-only write-ahead log of mutations made since the last snapshot.
+// Records are buffered per thread until that thread's commit(), so the
+// records of one operation reach the file together. Without a background
+// worker commit() appends and fsyncs right away; with one it only queues the
+// batch and the worker writes whatever piled up as one group commit.
+class Journal {
+private:
+    // One commit() worth of records; `done` marks a flush() barrier instead.
+    struct Batch {
+        vector<string> lines;
+        std::atomic<bool> *done = nullptr;
+    };
+
+    string dir;
+    string file;
+    std::FILE *out;
+    std::mutex writeLock;  // direct writes when there is no worker
+    std::atomic<size_t> records;
+    size_t compactEvery;
+    uint64_t gen;  // 0 for a journal without a JOURNAL_STARTED line
+
+    MpscQueue<Batch> queue;
+    std::thread worker;
+    std::atomic<unsigned> wakeups{0};
+    std::atomic<bool> urgent{false};
+    std::atomic<bool> stopping{false};
+    std::atomic<bool> failed{false};
+    std::chrono::milliseconds flushInterval{0};
+    Durability durability = Durability::FSYNC;
+
+    void append(RecordType type, const string &fields);
+    vector<string> &buffered();
+    bool writeLines(const vector<string> &lines);
+    void wake();
+    void run();
+
+public:
+    explicit Journal(const string &path, size_t compactEvery = 1000);
+    ~Journal();
+    Journal(const Journal&) = delete;
+    Journal& operator=(const Journal&) = delete;
+
+    const string &directory() const { return dir; }
+
+    void buyerAdded(const Buyer &b);
+    void accountOpened(const BankCustomer &acc);
+    void accountBalance(const BankCustomer &acc);
+    void sellerAdded(const seller &s);
+    void itemAdded(int sellerId, const Item &item);
+    void itemUpdated(int sellerId, const Item &item);
+    void itemRemoved(int sellerId, int itemId);
+    void orderPlaced(const Transaction &t);
+    void orderPaid(const Transaction &t);
+    void orderCancelled(int transactionId);
+    void userDeleted(int buyerId);
+
+    // Moves journal I/O onto a worker thread. Commits arriving within
+    // flushInterval of each other are written and synced together.
+    void startBackground(std::chrono::milliseconds flushInterval, Durability durability = Durability::FSYNC);
+    bool background() const { return worker.joinable(); }
+
+    bool commit();
+    // Blocks until every committed record is on disk; false if a write failed.
+    bool flush();
+    // True once enough records piled up that a snapshot should be written.
+    bool needsCompaction() const { return records.load(std::memory_order_relaxed) >= compactEvery; }
+    // Call after save_all succeeded: the snapshot now covers every record.
+    // Starts the next generation.
+    bool reset();
+    // Set AppState::coveredJournals past this before writing a snapshot, so
+    // the journal is not replayed over it if reset() never happens.
+    uint64_t generation() const { return gen; }
+
+    // Applies the journal in directory `path` to state, unless its generation
+    // is below state.coveredJournals; returns how many records it applied.
+    static size_t replay(AppState &state, const string &path);
+};
+
+}
+
+#endif // JOURNAL_H
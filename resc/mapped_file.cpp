@@ -0,0 +1,41 @@
+#include "mapped_file.h"
+#include <fstream>
+#include <iterator>
+#if !defined(_WIN32)
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+
+MappedFile::MappedFile(const std::string &path) : data(nullptr), length(0), mapped(false), opened(false) {
+#if !defined(_WIN32)
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) return;
+    opened = true;
+    struct stat st{};
+    if (::fstat(fd, &st) == 0 && st.st_size > 0) {
+        void *p = ::mmap(nullptr, static_cast<size_t>(st.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+        if (p != MAP_FAILED) {
+            ::madvise(p, static_cast<size_t>(st.st_size), MADV_SEQUENTIAL);
+            data = static_cast<const char *>(p);
+            length = static_cast<size_t>(st.st_size);
+            mapped = true;
+        }
+    }
+    ::close(fd);
+    if (mapped || st.st_size == 0) return;
+#endif
+    std::ifstream f(path, std::ios::binary);
+    if (!f) return;
+    opened = true;
+    fallback.assign(std::istreambuf_iterator<char>(f), std::istreambuf_iterator<char>());
+    data = fallback.data();
+    length = fallback.size();
+}
+
+MappedFile::~MappedFile() {
+#if !defined(_WIN32)
+    if (mapped) ::munmap(const_cast<char *>(data), length);
+#endif
+}
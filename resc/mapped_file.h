@@ -0,0 +1,31 @@
+#ifndef MAPPED_FILE_H
+#define MAPPED_FILE_H
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// Read-only view of a whole file. Uses mmap where available; on other
+// platforms the file is read into one buffer so callers see the same API.
+class MappedFile {
+private:
+    const char *data;
+    size_t length;
+    string fallback;
+    bool mapped;
+    bool opened;
+
+public:
+    explicit MappedFile(const string &path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return opened; }
+    string_view view() const { return string_view(data, length); }
+    size_t size() const { return length; }
+};
+
+#endif // MAPPED_FILE_H
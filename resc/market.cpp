@@ -0,0 +1,414 @@
+#include "market.h"
+#include "datetime.h"
+#include "persistence.h"
+#include <algorithm>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <unordered_map>
+
+using namespace std;
+
+namespace market {
+
+const char* statusName(Status status) {
+    switch (status) {
+        case OK: return "OK";
+        case NOT_FOUND: return "NOT_FOUND";
+        case NOT_LOGGED_IN: return "NOT_LOGGED_IN";
+        case NOT_A_SELLER: return "NOT_A_SELLER";
+        case ALREADY_EXISTS: return "ALREADY_EXISTS";
+        case NO_ACCOUNT: return "NO_ACCOUNT";
+        case DORMANT: return "DORMANT";
+        case INSUFFICIENT_FUNDS: return "INSUFFICIENT_FUNDS";
+        case OUT_OF_STOCK: return "OUT_OF_STOCK";
+        case INVALID: return "INVALID";
+        default: return "UNKNOWN";
+    }
+}
+
+using Shared = shared_lock<shared_mutex>;
+using Exclusive = unique_lock<shared_mutex>;
+using OrdersGuard = lock_guard<mutex>;
+
+// The user's linked bank account, or nullptr if it has none.
+static BankCustomer* accountOf(AppState& state, const Buyer* b) {
+    BankCustomer* acc = b ? state.accountOf(*b) : nullptr;
+    return acc && acc->getId() != 0 ? acc : nullptr;
+}
+
+// Caller holds state.orders.
+static const Transaction* pendingOrder(const AppState& state, int transactionId) {
+    const Transaction* order = state.findOrder(transactionId);
+    return order && order->getStatus() == PENDING ? order : nullptr;
+}
+
+// Caller holds the structure lock exclusively, or shared along with the
+// order's row lock.
+static Status cancelLocked(AppState& state, store::Journal& journal, int transactionId) {
+    {
+        OrdersGuard ordersLock(state.orders);
+        const Transaction* order = state.findPendingOrder(transactionId);
+        if (!order) return NOT_FOUND;
+        for (const auto& line : order->getItems()) {
+            if (Item item = state.findItem(order->getSellerId(), line.getItemId())) item.release(line.getQuantity());
+        }
+        state.closeOrder(transactionId, CANCELLED);
+    }
+    journal.orderCancelled(transactionId);
+    state.markDirty(TABLE_ITEMS | TABLE_TRANSACTIONS | TABLE_PENDING);
+    journal.commit();
+    return OK;
+}
+
+// Money arithmetic throws on overflow; these check first so an operation is
+// refused before it changes anything.
+static bool sumFits(Money a, Money b) {
+    try {
+        (void)(a + b);
+        return true;
+    } catch (const overflow_error&) {
+        return false;
+    }
+}
+
+static bool orderTotalFits(const vector<Item>& items, const vector<OrderLine>& lines) {
+    try {
+        Money total;
+        for (size_t i = 0; i < lines.size(); i++) total += items[i].getPrice() * lines[i].quantity;
+        return true;
+    } catch (const overflow_error&) {
+        return false;
+    }
+}
+
+void compactIfNeeded(AppState& state, store::Journal& journal) {
+    if (!journal.needsCompaction()) return;
+    Exclusive lock(state.structure);
+    // Another session may have compacted while we waited for the lock
+    if (!journal.needsCompaction()) return;
+    // Keep whichever snapshot format the database is already in
+    const string& path = journal.directory();
+    // The snapshot includes every record so far, should reset() not happen
+    state.coveredJournals = journal.generation() + 1;
+    if (store::save_all(state, path, store::detect_format(path))) {
+        state.clearDirty();
+        journal.reset();
+    }
+}
+
+Status registerBuyer(AppState& state, store::Journal& journal, const string& name, const string& email,
+                     const string& phone, const string& address, int& newBuyerId) {
+    if (!Buyer::isValidEmail(email) || !Buyer::isValidPhone(phone)) return INVALID;
+    {
+        Exclusive lock(state.structure);
+        newBuyerId = state.nextBuyerId;
+        Buyer& b = state.addBuyer(newBuyerId, name, email, phone, address, AccountHandle());
+        journal.buyerAdded(b);
+        journal.commit();
+    }
+    compactIfNeeded(state, journal);
+    return OK;
+}
+
+Status openAccount(AppState& state, store::Journal& journal, int buyerId, Money deposit) {
+    {
+        Exclusive lock(state.structure);
+        Buyer* buyer = state.findBuyer(buyerId);
+        if (!buyer) return NOT_FOUND;
+        if (accountOf(state, buyer)) return ALREADY_EXISTS;
+        BankCustomer& acc = state.addAccount(buyer->getId(), buyer->getName(), deposit);
+        buyer->setAccount(state.accountHandle(acc.getId()));
+        state.markDirty(TABLE_BUYERS);
+        journal.accountOpened(acc);
+        journal.commit();
+    }
+    compactIfNeeded(state, journal);
+    return OK;
+}
+
+Status topUp(AppState& state, store::Journal& journal, int buyerId, Money amount) {
+    if (amount <= Money()) return INVALID;
+    {
+        Shared lock(state.structure);
+        Buyer* buyer = state.findBuyer(buyerId);
+        if (!buyer) return NOT_FOUND;
+        BankCustomer* account = accountOf(state, buyer);
+        if (!account) return NO_ACCOUNT;
+        RowLocks::Guard row = state.rowLocks.lock({{RowKind::ACCOUNT, account->getId()}});
+        if (!sumFits(account->getBalance(), amount)) return INVALID;
+        account->addBalance(amount);
+        state.markDirty(TABLE_ACCOUNTS);
+        journal.accountBalance(*account);
+        // Committed under the row lock so balance records hit the journal in order
+        journal.commit();
+    }
+    compactIfNeeded(state, journal);
+    return OK;
+}
+
+Status upgradeToSeller(AppState& state, store::Journal& journal, int buyerId, const string& storeName, int& newSellerId) {
+    {
+        Exclusive lock(state.structure);
+        Buyer* buyer = state.findBuyer(buyerId);
+        if (!buyer) return NOT_FOUND;
+        if (state.findSellerByBuyer(buyerId)) return ALREADY_EXISTS;
+        if (!accountOf(state, buyer)) return NO_ACCOUNT;
+        newSellerId = state.nextSellerId;
+        seller& s = state.addSeller(buyer->getId(), newSellerId, storeName);
+        journal.sellerAdded(s);
+        journal.commit();
+    }
+    compactIfNeeded(state, journal);
+    return OK;
+}
+
+Status deleteUser(AppState& state, store::Journal& journal, int buyerId) {
+    {
+        Exclusive lock(state.structure);
+        if (!state.findBuyer(buyerId)) return NOT_FOUND;
+        // Nobody can pay for or cancel the user's pending orders, or those
+        // placed at their store, once they are gone; release the stock now.
+        vector<int> stranded;
+        {
+            OrdersGuard ordersLock(state.orders);
+            auto mine = state.pendingByBuyer.find(buyerId);
+            if (mine != state.pendingByBuyer.end()) stranded = mine->second;
+            if (const seller* s = state.findSellerByBuyer(buyerId)) {
+                auto sold = state.ordersBySeller.find(s->getSellerId());
+                if (sold != state.ordersBySeller.end()) {
+                    for (int id : sold->second) {
+                        if (pendingOrder(state, id) && state.findOrder(id)->getBuyerId() != buyerId) stranded.push_back(id);
+                    }
+                }
+            }
+        }
+        for (int id : stranded) cancelLocked(state, journal, id);
+        state.removeUser(buyerId);
+        journal.userDeleted(buyerId);
+        journal.commit();
+    }
+    compactIfNeeded(state, journal);
+    return OK;
+}
+
+Status placeOrder(AppState& state, store::Journal& journal, int buyerId, int sellerId,
+                  const vector<OrderLine>& lines, int& transactionId) {
+    if (lines.empty()) return INVALID;
+    {
+        Shared lock(state.structure);
+        Buyer* buyer = state.findBuyer(buyerId);
+        seller* s = state.findSeller(sellerId);
+        if (!buyer || !s) return NOT_FOUND;
+        vector<Item> items;
+        items.reserve(lines.size());
+        for (const auto& line : lines) {
+            Item item = state.findItem(sellerId, line.itemId);
+            if (!item) return NOT_FOUND;
+            if (line.quantity <= 0) return INVALID;
+            items.push_back(item);
+        }
+        if (!orderTotalFits(items, lines)) return INVALID;
+
+        // Reserve line by line, no lock: each item's stock is its own atomic.
+        // If any line runs short, hand back what the earlier lines took.
+        for (size_t i = 0; i < lines.size(); i++) {
+            if (!items[i].tryReserve(lines[i].quantity)) {
+                while (i-- > 0) items[i].release(lines[i].quantity);
+                return OUT_OF_STOCK;
+            }
+        }
+
+        {
+            OrdersGuard ordersLock(state.orders);
+            Transaction& order = state.createOrder(buyer->getId(), buyer->getNameId(), s->getSellerId(), s->getStoreNameId(),
+                                                   dt::current_day());
+            order.reserveItems(lines.size());
+            for (size_t i = 0; i < lines.size(); i++) {
+                order.addItem(items[i].getId(), items[i].getNameId(), lines[i].quantity, items[i].getPrice());
+            }
+            transactionId = order.getTransactionId();
+            journal.orderPlaced(order);
+            // Commit before another session can find the order: its payment
+            // must not reach the journal ahead of the reservation
+            journal.commit();
+            state.addPendingOrder(order);
+        }
+        state.markDirty(TABLE_ITEMS | TABLE_PENDING);
+    }
+    compactIfNeeded(state, journal);
+    return OK;
+}
+
+optional<Transaction> findPendingOrder(const AppState& state, int transactionId) {
+    Shared lock(state.structure);
+    OrdersGuard ordersLock(state.orders);
+    const Transaction* order = pendingOrder(state, transactionId);
+    if (!order) return nullopt;
+    return *order;
+}
+
+Status payOrder(AppState& state, store::Journal& journal, int buyerId, int transactionId, Money& newBalance) {
+    {
+        Shared lock(state.structure);
+        Buyer* buyer = state.findBuyer(buyerId);
+        if (!buyer) return NOT_FOUND;
+        BankCustomer* account = accountOf(state, buyer);
+        if (!account) return NO_ACCOUNT;
+
+        int sellerId;
+        {
+            OrdersGuard ordersLock(state.orders);
+            const Transaction* order = pendingOrder(state, transactionId);
+            if (!order || order->getBuyerId() != buyerId) return NOT_FOUND;
+            sellerId = order->getSellerId();
+        }
+        seller* s = state.findSeller(sellerId);
+        BankCustomer* payee = s ? accountOf(state, state.ownerOf(*s)) : nullptr;
+
+        // Only the order and the two accounts are locked, so payments between
+        // other buyers and sellers go ahead in parallel
+        RowLocks::Guard rows = state.rowLocks.lock({
+            {RowKind::ORDER, transactionId},
+            {RowKind::ACCOUNT, account->getId()},
+            {RowKind::ACCOUNT, payee ? payee->getId() : account->getId()}});
+
+        Money total;
+        {
+            // It may have been paid while we did not hold its row
+            OrdersGuard ordersLock(state.orders);
+            const Transaction* order = pendingOrder(state, transactionId);
+            if (!order) return NOT_FOUND;
+            total = order->getTotalAmount();
+        }
+        if (account->isDormant()) return DORMANT;
+        if (account->getBalance() < total) return INSUFFICIENT_FUNDS;
+        if (payee && payee != account && !sumFits(payee->getBalance(), total)) return INVALID;
+
+        account->withdrawBalance(total);
+        journal.accountBalance(*account);
+        if (payee) {
+            payee->addBalance(total);
+            journal.accountBalance(*payee);
+        }
+        {
+            OrdersGuard ordersLock(state.orders);
+            // The reserved units are sold now
+            for (const auto& line : state.findPendingOrder(transactionId)->getItems()) {
+                if (Item item = state.findItem(sellerId, line.getItemId())) item.consume(line.getQuantity());
+            }
+            const Transaction* paid = state.closeOrder(transactionId, PAID);
+            state.sales.add(*paid);
+            journal.orderPaid(*paid);
+        }
+        state.markDirty(TABLE_ACCOUNTS | TABLE_TRANSACTIONS | TABLE_PENDING);
+        newBalance = account->getBalance();
+        journal.commit();
+    }
+    compactIfNeeded(state, journal);
+    return OK;
+}
+
+Status cancelOrder(AppState& state, store::Journal& journal, int buyerId, int transactionId) {
+    {
+        Shared lock(state.structure);
+        {
+            OrdersGuard ordersLock(state.orders);
+            const Transaction* order = pendingOrder(state, transactionId);
+            if (!order || order->getBuyerId() != buyerId) return NOT_FOUND;
+        }
+        // Serializes with a payment of the same order
+        RowLocks::Guard row = state.rowLocks.lock({{RowKind::ORDER, transactionId}});
+        Status st = cancelLocked(state, journal, transactionId);
+        if (st != OK) return st;
+    }
+    compactIfNeeded(state, journal);
+    return OK;
+}
+
+size_t expireOrders(AppState& state, store::Journal& journal, int holdDays) {
+    size_t expired = 0;
+    {
+        Shared lock(state.structure);
+        vector<int> stale;
+        dt::Day today = dt::current_day();
+        {
+            OrdersGuard ordersLock(state.orders);
+            for (const auto& order : state.pendingOrders) {
+                // Orders with an unreadable or future date are left alone
+                dt::Day day = order.getDay();
+                if (day != dt::NO_DAY && day < today - holdDays) stale.push_back(order.getTransactionId());
+            }
+        }
+        for (int id : stale) {
+            RowLocks::Guard row = state.rowLocks.lock({{RowKind::ORDER, id}});
+            if (cancelLocked(state, journal, id) == OK) expired++;
+        }
+    }
+    if (expired) compactIfNeeded(state, journal);
+    return expired;
+}
+
+Status addItem(AppState& state, store::Journal& journal, int sellerId, int itemId, const string& name, int quantity, Money price) {
+    if (quantity < 0 || price < Money()) return INVALID;
+    {
+        Exclusive lock(state.structure);
+        seller* s = state.findSeller(sellerId);
+        if (!s) return NOT_A_SELLER;
+        if (state.findItem(sellerId, itemId)) return ALREADY_EXISTS;
+        Item item = state.addItem(*s, itemId, name, quantity, price);
+        journal.itemAdded(sellerId, item);
+        journal.commit();
+    }
+    compactIfNeeded(state, journal);
+    return OK;
+}
+
+Status removeItem(AppState& state, store::Journal& journal, int sellerId, int itemId) {
+    {
+        Exclusive lock(state.structure);
+        if (!state.findSeller(sellerId)) return NOT_A_SELLER;
+        if (!state.removeItem(sellerId, itemId)) return NOT_FOUND;
+        journal.itemRemoved(sellerId, itemId);
+        journal.commit();
+    }
+    compactIfNeeded(state, journal);
+    return OK;
+}
+
+// Reads the id list backwards from `offset`, so the cost follows the page
+// size rather than how many orders the key has.
+static OrderPage page(const AppState& state, const unordered_map<int, vector<int>>& index, int key,
+                      size_t offset, size_t limit) {
+    OrderPage out;
+    Shared lock(state.structure);
+    OrdersGuard ordersLock(state.orders);
+    auto it = index.find(key);
+    if (it == index.end()) return out;
+    const vector<int>& ids = it->second;
+    out.total = ids.size();
+    for (size_t i = offset; i < ids.size() && out.orders.size() < limit; i++) {
+        if (const Transaction* t = state.findOrder(ids[ids.size() - 1 - i])) out.orders.push_back(*t);
+    }
+    return out;
+}
+
+OrderPage pendingOrdersForBuyer(const AppState& state, int buyerId, size_t offset, size_t limit) {
+    return page(state, state.pendingByBuyer, buyerId, offset, limit);
+}
+
+OrderPage ordersForBuyer(const AppState& state, int buyerId, size_t offset, size_t limit) {
+    return page(state, state.ordersByBuyer, buyerId, offset, limit);
+}
+
+OrderPage ordersForSeller(const AppState& state, int sellerId, size_t offset, size_t limit) {
+    return page(state, state.ordersBySeller, sellerId, offset, limit);
+}
+
+analytics::Report salesReport(const AppState& state, int sellerId) {
+    Shared lock(state.structure);
+    OrdersGuard ordersLock(state.orders);
+    return state.sales.report(sellerId);
+}
+
+}
@@ -0,0 +1,87 @@
+#ifndef MARKET_H
+#define MARKET_H
+
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <vector>
+#include "app_state.h"
+#include "journal.h"
+
+using namespace std;
+
+// Marketplace operations shared by the console menus and the socket server.
+// Each mutating call updates AppState, journals the change and commits it.
+// Nothing here reads cin or prints; callers decide how to report the Status.
+//
+// Every call takes the AppState locks it needs, so sessions on different
+// threads may call in concurrently. Payments and orders only lock the rows
+// involved; registering, upgrading, deleting and item add/remove lock the
+// whole state. Queries return copies so nothing points into shared vectors.
+namespace market {
+
+enum Status {
+    OK,
+    NOT_FOUND,
+    NOT_LOGGED_IN,
+    NOT_A_SELLER,
+    ALREADY_EXISTS,
+    NO_ACCOUNT,
+    DORMANT,
+    INSUFFICIENT_FUNDS,
+    OUT_OF_STOCK,
+    INVALID
+};
+
+const char* statusName(Status status);
+
+struct OrderLine {
+    int itemId;
+    int quantity;
+};
+
+// Folds the journal into the snapshot once it has grown large. Takes the
+// structure lock exclusively, so never call it while holding AppState locks.
+void compactIfNeeded(AppState& state, store::Journal& journal);
+
+Status registerBuyer(AppState& state, store::Journal& journal, const string& name, const string& email,
+                     const string& phone, const string& address, int& newBuyerId);
+Status openAccount(AppState& state, store::Journal& journal, int buyerId, Money deposit);
+Status topUp(AppState& state, store::Journal& journal, int buyerId, Money amount);
+Status upgradeToSeller(AppState& state, store::Journal& journal, int buyerId, const string& storeName, int& newSellerId);
+Status deleteUser(AppState& state, store::Journal& journal, int buyerId);
+
+Status placeOrder(AppState& state, store::Journal& journal, int buyerId, int sellerId,
+                  const vector<OrderLine>& lines, int& transactionId);
+Status payOrder(AppState& state, store::Journal& journal, int buyerId, int transactionId, Money& newBalance);
+// Placing an order reserves its stock; paying sells it, cancelling or
+// expiring puts it back. Cancelled orders stay on record as CANCELLED.
+Status cancelOrder(AppState& state, store::Journal& journal, int buyerId, int transactionId);
+// Cancels pending orders placed more than holdDays ago; returns how many.
+// Orders without a readable date are never expired.
+size_t expireOrders(AppState& state, store::Journal& journal, int holdDays);
+
+// How long a pending order holds its stock before expireOrders releases it.
+const int ORDER_HOLD_DAYS = 3;
+
+Status addItem(AppState& state, store::Journal& journal, int sellerId, int itemId, const string& name, int quantity, Money price);
+Status removeItem(AppState& state, store::Journal& journal, int sellerId, int itemId);
+
+optional<Transaction> findPendingOrder(const AppState& state, int transactionId);
+
+// One page of an order listing, newest first, and the listing's full length.
+struct OrderPage {
+    vector<Transaction> orders;
+    size_t total = 0;
+};
+// Listings skip `offset` orders and return at most `limit`; the work done
+// depends on the page, not on how many orders there are.
+OrderPage pendingOrdersForBuyer(const AppState& state, int buyerId, size_t offset = 0, size_t limit = SIZE_MAX);
+OrderPage ordersForBuyer(const AppState& state, int buyerId, size_t offset = 0, size_t limit = SIZE_MAX);
+OrderPage ordersForSeller(const AppState& state, int sellerId, size_t offset = 0, size_t limit = SIZE_MAX);
+// Revenue, order and unit totals over all time, today, 7 and 30 days, plus best sellers.
+analytics::Report salesReport(const AppState& state, int sellerId);
+
+}
+
+#endif // MARKET_H
@@ -0,0 +1,145 @@
+#include "money.h"
+#include <charconv>
+#include <cmath>
+#include <istream>
+#include <limits>
+#include <ostream>
+#include <stdexcept>
+
+using namespace std;
+
+static const int64_t MAX_CENTS = numeric_limits<int64_t>::max();
+static const int64_t MIN_CENTS = numeric_limits<int64_t>::min();
+
+Money Money::fromDouble(double amount) {
+    double cents = std::round(amount * SCALE);
+    // 2^63 is exactly representable; anything at or past it does not fit
+    if (!(cents > -9223372036854775808.0 && cents < 9223372036854775808.0)) {
+        throw overflow_error("money amount out of range");
+    }
+    return Money(static_cast<int64_t>(cents));
+}
+
+bool Money::parse(string_view text, Money &out) {
+    const char *p = text.data();
+    const char *end = p + text.size();
+    bool negative = false;
+    if (p != end && (*p == '-' || *p == '+')) negative = *p++ == '-';
+    if (p == end || *p == '-' || *p == '+') return false;
+
+    // Plain decimal with at most two fraction digits: exact integer path
+    uint64_t units = 0;
+    auto r = from_chars(p, end, units);
+    bool exact = r.ec == errc() && r.ptr != p;
+    const char *q = r.ptr;
+    int64_t fraction = 0;
+    if (exact && q != end && *q == '.') {
+        const char *digits = ++q;
+        while (q != end && *q >= '0' && *q <= '9' && q - digits < 2) fraction = fraction * 10 + (*q++ - '0');
+        if (q - digits == 1) fraction *= 10;
+    }
+    if (exact && q == end) {
+        // The magnitude may reach 2^63 cents when negative, 2^63 - 1 otherwise
+        uint64_t limit = negative ? 0 - static_cast<uint64_t>(MIN_CENTS) : static_cast<uint64_t>(MAX_CENTS);
+        uint64_t whole = limit / SCALE, part = limit % SCALE;
+        if (units > whole || (units == whole && static_cast<uint64_t>(fraction) > part)) return false;
+        uint64_t cents = units * SCALE + static_cast<uint64_t>(fraction);
+        out = Money(static_cast<int64_t>(negative ? 0 - cents : cents));
+        return true;
+    }
+
+    // Anything else that is still a number, e.g. "1e3" or "0.125"
+    double value = 0;
+    auto d = from_chars(p, end, value);
+    if (d.ec != errc() || d.ptr != end || !std::isfinite(value)) return false;
+    try {
+        out = fromDouble(negative ? -value : value);
+    } catch (const overflow_error &) {
+        return false;
+    }
+    return true;
+}
+
+size_t Money::format(char *buf) const {
+    // Work on the magnitude as unsigned so INT64_MIN formats too
+    uint64_t v = minor < 0 ? 0 - static_cast<uint64_t>(minor) : static_cast<uint64_t>(minor);
+    char tmp[MAX_CHARS];
+    size_t n = 0;
+    tmp[n++] = static_cast<char>('0' + v % 10);
+    v /= 10;
+    tmp[n++] = static_cast<char>('0' + v % 10);
+    v /= 10;
+    tmp[n++] = '.';
+    do {
+        tmp[n++] = static_cast<char>('0' + v % 10);
+        v /= 10;
+    } while (v != 0);
+    if (minor < 0) tmp[n++] = '-';
+    for (size_t i = 0; i < n; i++) buf[i] = tmp[n - 1 - i];
+    return n;
+}
+
+string Money::toString() const {
+    char buf[MAX_CHARS];
+    return string(buf, format(buf));
+}
+
+Money Money::operator+(Money other) const {
+    if ((other.minor > 0 && minor > MAX_CENTS - other.minor) || (other.minor < 0 && minor < MIN_CENTS - other.minor)) {
+        throw overflow_error("money addition overflows");
+    }
+    return Money(minor + other.minor);
+}
+
+Money Money::operator-(Money other) const {
+    if ((other.minor < 0 && minor > MAX_CENTS + other.minor) || (other.minor > 0 && minor < MIN_CENTS + other.minor)) {
+        throw overflow_error("money subtraction overflows");
+    }
+    return Money(minor - other.minor);
+}
+
+Money Money::operator*(int64_t quantity) const {
+    int64_t a = minor, b = quantity;
+    bool overflow = a > 0 ? (b > 0 ? a > MAX_CENTS / b : b < MIN_CENTS / a)
+                          : (b > 0 ? a < MIN_CENTS / b : (a != 0 && b < MAX_CENTS / a));
+    if (overflow) throw overflow_error("money multiplication overflows");
+    return Money(a * b);
+}
+
+// high * 2^32 + low, checked: the two halves MoneySum and Money::sum keep.
+static Money fromHalves(int64_t high, uint64_t low) {
+    // Carrying low's upper half cannot overflow; high is at most 2^62 here
+    high += static_cast<int64_t>(low >> 32);
+    if (high > (MAX_CENTS >> 32) || high < (MIN_CENTS >> 32)) throw overflow_error("money sum overflows");
+    return Money::fromCents(static_cast<int64_t>(static_cast<uint64_t>(high) << 32 | (low & 0xffffffffu)));
+}
+
+Money Money::sum(const int64_t *cents, size_t n) {
+    Money total;
+    for (size_t begin = 0; begin < n; begin += MoneySum::MAX_ADDS) {
+        size_t end = n - begin < MoneySum::MAX_ADDS ? n : begin + MoneySum::MAX_ADDS;
+        int64_t high = 0;
+        uint64_t low = 0;
+        for (size_t i = begin; i < end; i++) {
+            high += cents[i] >> 32;
+            low += static_cast<uint32_t>(cents[i]);
+        }
+        total += fromHalves(high, low);
+    }
+    return total;
+}
+
+Money MoneySum::total() const {
+    return fromHalves(high, low);
+}
+
+ostream &operator<<(ostream &os, Money amount) {
+    char buf[Money::MAX_CHARS];
+    return os.write(buf, static_cast<streamsize>(amount.format(buf)));
+}
+
+istream &operator>>(istream &is, Money &amount) {
+    string token;
+    if (is >> token && !Money::parse(token, amount)) is.setstate(ios::failbit);
+    return is;
+}
@@ -0,0 +1,80 @@
+#ifndef MONEY_H
+#define MONEY_H
+
+#include <compare>
+#include <cstdint>
+#include <iosfwd>
+#include <string>
+#include <string_view>
+
+using namespace std;
+
+// An amount of money held as an integer count of cents, so balances and
+// totals add up exactly. Arithmetic throws overflow_error rather than wrap.
+class Money {
+private:
+    int64_t minor = 0;
+
+    explicit constexpr Money(int64_t cents) : minor(cents) {}
+
+public:
+    static constexpr int64_t SCALE = 100;
+    // Longest format() output: sign, 17 digits, point, 2 decimals
+    static constexpr size_t MAX_CHARS = 24;
+
+    constexpr Money() = default;
+    static constexpr Money fromCents(int64_t cents) { return Money(cents); }
+    // Rounds to the nearest cent; only for reading legacy floating-point data.
+    static Money fromDouble(double amount);
+
+    constexpr int64_t cents() const { return minor; }
+
+    // Accepts "12", "12.5", "-12.34"; exponent or longer fractions (as older
+    // data files hold, e.g. "6.76768e+09") are rounded to the nearest cent.
+    static bool parse(string_view text, Money &out);
+    // Writes e.g. "-12.34", no locale, no terminator; returns the length.
+    size_t format(char *buf) const;
+    string toString() const;
+
+    // Adds up n amounts without checking each step, so the loop has no
+    // branches and vectorizes; only the total is checked. Throws
+    // overflow_error if it does not fit.
+    static Money sum(const int64_t *cents, size_t n);
+
+    Money operator+(Money other) const;
+    Money operator-(Money other) const;
+    Money operator*(int64_t quantity) const;
+    Money &operator+=(Money other) { return *this = *this + other; }
+    Money &operator-=(Money other) { return *this = *this - other; }
+
+    constexpr auto operator<=>(const Money &) const = default;
+};
+
+ostream &operator<<(ostream &os, Money amount);
+// Reads one token with Money::parse; sets failbit if it is not an amount.
+istream &operator>>(istream &is, Money &amount);
+
+// A running total for long sums: add() splits each amount into its upper and
+// lower 32 bits and keeps a sum of each, which cannot overflow before 2^31
+// adds, so it needs no check. total() checks the result once.
+class MoneySum {
+private:
+    int64_t high = 0;
+    uint64_t low = 0;
+
+public:
+    static constexpr size_t MAX_ADDS = size_t(1) << 31;
+
+    void add(Money amount) {
+        high += amount.cents() >> 32;
+        low += static_cast<uint32_t>(amount.cents());
+    }
+    MoneySum &operator+=(Money amount) {
+        add(amount);
+        return *this;
+    }
+    // Throws overflow_error if the sum does not fit in a Money.
+    Money total() const;
+};
+
+#endif // MONEY_H
@@ -0,0 +1,48 @@
+#ifndef MPSC_QUEUE_H
+#define MPSC_QUEUE_H
+
+#include <atomic>
+#include <utility>
+
+// Unbounded lock-free multi-producer / single-consumer queue (Vyukov).
+// push() is wait-free; pop() may briefly report empty while a producer is
+// between its two steps, the consumer just picks that node up next time.
+template <typename T>
+class MpscQueue {
+private:
+    struct Node {
+        std::atomic<Node*> next{nullptr};
+        T value{};
+    };
+
+    std::atomic<Node*> head;  // producers append here
+    Node* tail;               // consumer-owned dummy node
+
+public:
+    MpscQueue() : head(new Node), tail(head.load()) {}
+    ~MpscQueue() {
+        T discard;
+        while (pop(discard)) {}
+        delete tail;
+    }
+    MpscQueue(const MpscQueue&) = delete;
+    MpscQueue& operator=(const MpscQueue&) = delete;
+
+    void push(T value) {
+        Node* n = new Node;
+        n->value = std::move(value);
+        Node* prev = head.exchange(n, std::memory_order_acq_rel);
+        prev->next.store(n, std::memory_order_release);
+    }
+
+    bool pop(T& out) {
+        Node* next = tail->next.load(std::memory_order_acquire);
+        if (!next) return false;
+        out = std::move(next->value);
+        delete tail;
+        tail = next;
+        return true;
+    }
+};
+
+#endif // MPSC_QUEUE_H
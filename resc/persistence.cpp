@@ -5,215 +5,328 @@
 #include <vector>
 #include <memory>
 #include <string>
+#include <string_view>
+#include <charconv>
+#include <unordered_map>
+#include <fcntl.h>
+#if defined(_WIN32)
+#include <io.h>
+#else
+#include <unistd.h>
+#endif
 
 #include "persistence.h"
+#include "mapped_file.h"
 #include "bank_customer.h"
 #include "buyer.h"
 #include "seller.h"
 #include "transaction.h"
+#include "journal.h"
+#include "snapshot.h"
 
 namespace fs = std::filesystem;
 
 namespace store {
 
-static std::string safe(const std::string &s) {
-    std::string out = s;
+std::string safe(std::string_view s) {
+    std::string out(s);
     for (auto &c : out) if (c == '\n') c = ' ';
     return out;
 }
 
+std::vector<std::string> split_fields(const std::string &line) {
+    std::istringstream iss(line);
+    std::string tok;
+    std::vector<std::string> cols;
+    while (std::getline(iss, tok, '|')) cols.push_back(tok);
+    return cols;
+}
+
 bool ensure_data_dir(const std::string &path) {
     std::error_code ec;
     fs::create_directories(path, ec);
     return !ec;
 }
 
-bool save_all(const AppState &state, const std::string &path) {
+// fsync on a file or, on POSIX, a directory opened just for it.
+static bool sync_path(const std::string &path, bool directory) {
+#if defined(_WIN32)
+    // Directory entries cannot be synced here; the rename is as durable as it gets
+    if (directory) return true;
+    int fd = _open(path.c_str(), _O_RDWR);
+    if (fd < 0) return false;
+    bool ok = _commit(fd) == 0;
+    _close(fd);
+#else
+    int fd = ::open(path.c_str(), directory ? O_RDONLY | O_DIRECTORY : O_RDONLY);
+    if (fd < 0) return false;
+    bool ok = ::fsync(fd) == 0;
+    ::close(fd);
+#endif
+    return ok;
+}
+
+bool replace_file(const std::string &tmp, const std::string &file) {
+    if (!sync_path(tmp, false)) return false;
+    std::error_code ec;
+    fs::rename(tmp, file, ec);
+    if (ec) return false;
+    std::string dir = fs::path(file).parent_path().string();
+    return sync_path(dir.empty() ? "." : dir, true);
+}
+
+// Writes one table to <name>.tmp and renames it over the old file, so readers
+// and crashes only ever see a complete table.
+template <typename Fn>
+static bool write_table(const std::string &path, const std::string &name, Fn &&write) {
+    std::string file = path + "/" + name;
+    {
+        std::ofstream f(file + ".tmp", std::ios::trunc);
+        write(f);
+        f.flush();
+        if (!f) return false;
+    }
+    return replace_file(file + ".tmp", file);
+}
+
+static void write_order(std::ostream &f, const Transaction &t) {
+    f << t.getTransactionId() << '|' << t.getBuyerId() << '|' << safe(t.getBuyerName()) << '|'
+      << t.getSellerId() << '|' << safe(t.getSellerName()) << '|'
+      << t.getTotalAmount() << '|' << t.getStatus() << '|' << safe(t.getDate()) << "\n";
+}
+
+bool save_all(const AppState &state, const std::string &path, Format format) {
+    if (state.snapshotCorrupt) return false;
+    if (state.dirty == 0) return true;
+    // The binary snapshot is a single file, so any change rewrites all of it
+    if (format == Format::BINARY) return save_binary(state, path);
     if (!ensure_data_dir(path)) return false;
+    bool ok = true;
 
     // buyers.txt: id|name|email|phone|address|hasAccount
-    {
-        std::ofstream f(path + "/buyers.txt");
+    if (state.isDirty(TABLE_BUYERS)) ok &= write_table(path, "buyers.txt", [&](std::ostream &f) {
         for (const auto &b : state.buyers) {
             f << b.getId() << '|' << safe(b.getName()) << '|' << safe(b.getEmail()) << '|' 
               << safe(b.getPhone()) << '|' << safe(b.getAddress()) << '|' 
-              << ((b.getAccount() && b.getAccount()->getId()!=0)?1:0) << "\n";
+              << ((state.accountOf(b) && state.accountOf(b)->getId()!=0)?1:0) << "\n";
         }
-    }
+    });
 
-    // sellers.txt: buyerId|sellerId|storeName
-    {
-        std::ofstream f(path + "/sellers.txt");
+    // sellers.txt: buyerId|sellerId|storeName, one storefront per user; the
+    // owner's profile and account are only in buyers.txt
+    if (state.isDirty(TABLE_SELLERS)) ok &= write_table(path, "sellers.txt", [&](std::ostream &f) {
         for (const auto &s : state.sellers) {
-            f << s.getId() << '|' << s.getSellerId() << '|' << safe(s.getStoreName()) << "\n";
+            f << s.getUserId() << '|' << s.getSellerId() << '|' << safe(s.getStoreName()) << "\n";
         }
-    }
+    });
 
     // accounts.txt: id|name|balance
-    {
-        std::ofstream f(path + "/accounts.txt");
+    if (state.isDirty(TABLE_ACCOUNTS)) ok &= write_table(path, "accounts.txt", [&](std::ostream &f) {
         for (const auto &acc : state.bankAccounts) {
-            if (!acc) continue;
-            f << acc->getId() << '|' << safe(acc->getName()) << '|' << acc->getBalance() << "\n";
+            f << acc.getId() << '|' << safe(acc.getName()) << '|' << acc.getBalance() << "\n";
         }
-    }
+    });
 
     // items.txt: sellerId|itemId|name|qty|price
-    {
-        std::ofstream f(path + "/items.txt");
-        for (const auto &s : state.sellers) {
-            for (const auto &item : s.getItems()) {
-                f << s.getSellerId() << '|' << item.getId() << '|' << safe(item.getName()) << '|' << item.getQuantity() << '|' << item.getPrice() << "\n";
+    if (state.isDirty(TABLE_ITEMS)) ok &= write_table(path, "items.txt", [&](std::ostream &f) {
+        const Catalog &c = state.catalog;
+        for (size_t r = 0; r < c.size(); r++) {
+            f << c.sellerId(r) << '|' << c.itemId(r) << '|' << safe(c.name(r)) << '|' << c.quantity(r) << '|' << c.price(r) << "\n";
+        }
+    });
+
+    // transactions.txt and pending_orders.txt: id|buyerId|buyerName|sellerId|sellerName|total|status|date
+    if (state.isDirty(TABLE_TRANSACTIONS)) ok &= write_table(path, "transactions.txt", [&](std::ostream &f) {
+        for (const auto &t : state.transactions) write_order(f, t);
+    });
+    if (state.isDirty(TABLE_PENDING)) ok &= write_table(path, "pending_orders.txt", [&](std::ostream &f) {
+        for (const auto &t : state.pendingOrders) write_order(f, t);
+    });
+
+    // transaction_items.txt: transactionId|itemId|name|qty|price, for both order tables
+    if (state.isDirty(TABLE_TRANSACTIONS) || state.isDirty(TABLE_PENDING)) {
+        ok &= write_table(path, "transaction_items.txt", [&](std::ostream &f) {
+            for (const auto *orders : {&state.transactions, &state.pendingOrders}) {
+                for (const auto &t : *orders) {
+                    for (const auto &item : t.getItems()) {
+                        f << t.getTransactionId() << '|' << item.getItemId() << '|' << safe(item.getItemName()) << '|'
+                          << item.getQuantity() << '|' << item.getPricePerUnit() << "\n";
+                    }
+                }
             }
+        });
+    }
+
+    // covered_journals.txt: state.coveredJournals, written only once every
+    // table above is on disk
+    if (ok) ok = write_table(path, "covered_journals.txt", [&](std::ostream &f) { f << state.coveredJournals << "\n"; });
+
+    return ok;
+}
+
+// Splits one '|'-delimited row into views over the caller's buffer.
+static void split_row(std::string_view line, std::vector<std::string_view> &cols) {
+    cols.clear();
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    size_t start = 0;
+    while (true) {
+        size_t bar = line.find('|', start);
+        if (bar == std::string_view::npos) {
+            cols.push_back(line.substr(start));
+            return;
         }
+        cols.push_back(line.substr(start, bar - start));
+        start = bar + 1;
     }
+}
 
-    // transactions.txt: id|buyerId|buyerName|sellerId|sellerName|total|status|date
-    {
-        std::ofstream f(path + "/transactions.txt");
-        for (const auto &t : state.transactions) {
-            f << t.getTransactionId() << '|' << t.getBuyerId() << '|' << safe(t.getBuyerName()) << '|'
-              << t.getSellerId() << '|' << safe(t.getSellerName()) << '|'
-              << t.getTotalAmount() << '|' << t.getStatus() << '|' << safe(t.getDate()) << "\n";
+template <typename T>
+static bool parse(std::string_view tok, T &out) {
+    return std::from_chars(tok.data(), tok.data() + tok.size(), out).ec == std::errc();
+}
+
+// Amounts are written to the cent; older files may hold doubles.
+static bool parse(std::string_view tok, Money &out) {
+    return Money::parse(tok, out);
+}
+
+// Cheap upper bound on the row count, used to reserve before bulk loading.
+static size_t count_rows(const std::string &file) {
+    MappedFile mf(file);
+    std::string_view v = mf.view();
+    return static_cast<size_t>(std::count(v.begin(), v.end(), '\n')) + 1;
+}
+
+// Calls fn(cols) for every non-comment row of a table. Returns false if the file is missing.
+template <typename Fn>
+static bool for_each_row(const std::string &file, LoadMode mode, Fn &&fn) {
+    std::vector<std::string_view> cols;
+    if (mode == LoadMode::MAPPED) {
+        MappedFile mf(file);
+        if (!mf.isOpen()) return false;
+        std::string_view rest = mf.view();
+        while (!rest.empty()) {
+            size_t nl = rest.find('\n');
+            std::string_view line = rest.substr(0, nl);
+            rest = nl == std::string_view::npos ? std::string_view() : rest.substr(nl + 1);
+            if (line.empty() || line[0] == '#') continue;
+            split_row(line, cols);
+            fn(cols);
         }
+        return true;
     }
 
+    std::ifstream f(file);
+    if (!f) return false;
+    std::string line;
+    while (std::getline(f, line)) {
+        if (line.empty() || line[0] == '#') continue;
+        split_row(line, cols);
+        fn(cols);
+    }
     return true;
 }
 
-bool load_all(AppState& state, const std::string& path) {
+static bool load_text(AppState& state, const std::string& path, LoadMode mode) {
     bool any = false;
+    using Row = std::vector<std::string_view>;
+
+    // The add helpers maintain the AppState indexes, so each join below is one hash probe.
 
     // accounts.txt
-    {
-        std::ifstream f(path + "/accounts.txt");
-        if (f) {
-            any = true;
-            std::string line;
-            while (std::getline(f, line)) {
-                if (line.empty() || line[0] == '#') continue;
-                std::istringstream iss(line);
-                std::string tok;
-                std::vector<std::string> cols;
-                while (std::getline(iss, tok, '|')) cols.push_back(tok);
-                if (cols.size() >= 3) {
-                    int id = std::stoi(cols[0]);
-                    std::string name = cols[1];
-                    double bal = std::stod(cols[2]);
-                    state.bankAccounts.push_back(std::make_unique<BankCustomer>(id, name, bal));
-                }
-            }
-        }
-    }
+    any |= for_each_row(path + "/accounts.txt", mode, [&](const Row &cols) {
+        int id;
+        Money bal;
+        if (cols.size() < 3 || !parse(cols[0], id) || !parse(cols[2], bal)) return;
+        state.addAccount(id, cols[1], bal);
+    });
 
     // buyers.txt
-    {
-        std::ifstream f(path + "/buyers.txt");
-        if (f) {
-            any = true;
-            std::string line;
-            while (std::getline(f, line)) {
-                if (line.empty() || line[0] == '#') continue;
-                std::istringstream iss(line);
-                std::string tok;
-                std::vector<std::string> cols;
-                while (std::getline(iss, tok, '|')) cols.push_back(tok);
-                if (cols.size() >= 6) {
-                    int id = std::stoi(cols[0]);
-                    std::string name = cols[1];
-                    std::string email = cols[2];
-                    std::string phone = cols[3];
-                    std::string address = cols[4];
-                    int hasAcc = std::stoi(cols[5]);
-                    BankCustomer* accPtr = nullptr;
-                    if (hasAcc) {
-                        for (auto &acc : state.bankAccounts) if (acc && acc->getId() == id) { accPtr = acc.get(); break; }
-                    }
-                    state.buyers.emplace_back(id, name, email, phone, address, accPtr);
-                }
-            }
-        }
-    }
+    any |= for_each_row(path + "/buyers.txt", mode, [&](const Row &cols) {
+        int id, hasAcc;
+        if (cols.size() < 6 || !parse(cols[0], id) || !parse(cols[5], hasAcc)) return;
+        AccountHandle acc = hasAcc ? state.accountHandle(id) : AccountHandle();
+        state.addBuyer(id, cols[1], std::string(cols[2]), std::string(cols[3]), std::string(cols[4]), acc);
+    });
 
     // sellers.txt
-    {
-        std::ifstream f(path + "/sellers.txt");
-        if (f) {
-            any = true;
-            std::string line;
-            while (std::getline(f, line)) {
-                if (line.empty() || line[0] == '#') continue;
-                std::istringstream iss(line);
-                std::string tok;
-                std::vector<std::string> cols;
-                while (std::getline(iss, tok, '|')) cols.push_back(tok);
-                if (cols.size() >= 3) {
-                    int buyerId = std::stoi(cols[0]);
-                    int sellerId = std::stoi(cols[1]);
-                    std::string storeName = cols[2];
-                    // find buyer
-                    auto itb = std::find_if(state.buyers.begin(), state.buyers.end(), [buyerId](const Buyer& b){ return b.getId()==buyerId; });
-                    if (itb != state.buyers.end()) {
-                        state.sellers.emplace_back(*itb, sellerId, storeName);
-                    }
-                }
-            }
-        }
-    }
+    any |= for_each_row(path + "/sellers.txt", mode, [&](const Row &cols) {
+        int buyerId, sellerId;
+        if (cols.size() < 3 || !parse(cols[0], buyerId) || !parse(cols[1], sellerId)) return;
+        if (state.findBuyer(buyerId)) state.addSeller(buyerId, sellerId, cols[2]);
+    });
 
-    // transactions.txt
-    {
-        std::ifstream f(path + "/transactions.txt");
-        if (f) {
-            std::string line;
-            while (std::getline(f, line)) {
-                if (line.empty() || line[0] == '#') continue;
-                std::istringstream iss(line);
-                std::string tok;
-                std::vector<std::string> cols;
-                while (std::getline(iss, tok, '|')) cols.push_back(tok);
-                if (cols.size() >= 8) {
-                    // int id = std::stoi(cols[0]);  // Transaction ID not used for reconstruction
-                    int buyerId = std::stoi(cols[1]);
-                    std::string buyerName = cols[2];
-                    int sellerId = std::stoi(cols[3]);
-                    std::string sellerName = cols[4];
-                    // double total = std::stod(cols[5]);  // Total calculated from items, not loaded
-                    // std::string status = cols[6];  // Status not used in current constructor
-                    std::string date = cols[7];
-                    state.transactions.push_back(Transaction(buyerId, buyerName, sellerId, sellerName, date));
-                }
-            }
-        }
-    }
+    // transactions.txt, pending_orders.txt, then their line items
+    auto load_orders = [&](const std::string &file, OrderList &orders) {
+        orders.reserve(orders.size() + count_rows(file));
+        for_each_row(file, mode, [&](const Row &cols) {
+            int id, buyerId, sellerId, status;
+            Money total;
+            if (cols.size() < 8 || !parse(cols[0], id) || !parse(cols[1], buyerId) || !parse(cols[3], sellerId)
+                || !parse(cols[5], total) || !parse(cols[6], status)) return;
+            orders.push_back(&state.createOrder(id, buyerId, symbols::intern(cols[2]), sellerId, symbols::intern(cols[4]),
+                                                total, static_cast<TransactionStatus>(status), dt::from_string(cols[7])));
+        });
+    };
+    load_orders(path + "/transactions.txt", state.transactions);
+    load_orders(path + "/pending_orders.txt", state.pendingOrders);
+
+    std::unordered_map<int, Transaction*> orderById;
+    orderById.reserve(state.transactions.size() + state.pendingOrders.size());
+    for (auto &t : state.transactions) orderById.emplace(t.getTransactionId(), &t);
+    for (auto &t : state.pendingOrders) orderById.emplace(t.getTransactionId(), &t);
+    for_each_row(path + "/transaction_items.txt", mode, [&](const Row &cols) {
+        int txnId, itemId, qty;
+        Money price;
+        if (cols.size() < 5 || !parse(cols[0], txnId) || !parse(cols[1], itemId)
+            || !parse(cols[3], qty) || !parse(cols[4], price)) return;
+        auto it = orderById.find(txnId);
+        if (it != orderById.end()) it->second->restoreItem(itemId, symbols::intern(cols[2]), qty, price);
+    });
+
+    for_each_row(path + "/covered_journals.txt", mode, [&](const Row &cols) {
+        if (!cols.empty()) parse(cols[0], state.coveredJournals);
+    });
 
     // items.txt
-    {
-        std::ifstream f(path + "/items.txt");
-        if (f) {
-            std::string line;
-            while (std::getline(f, line)) {
-                if (line.empty() || line[0] == '#') continue;
-                std::istringstream iss(line);
-                std::string tok;
-                std::vector<std::string> cols;
-                while (std::getline(iss, tok, '|')) cols.push_back(tok);
-                if (cols.size() >= 5) {
-                    int sellerId = std::stoi(cols[0]);
-                    int itemId = std::stoi(cols[1]);
-                    std::string name = cols[2];
-                    int qty = std::stoi(cols[3]);
-                    double price = std::stod(cols[4]);
-                    auto its = std::find_if(state.sellers.begin(), state.sellers.end(), [sellerId](const seller& s){ return s.getSellerId()==sellerId; });
-                    if (its != state.sellers.end()) {
-                        its->addNewItem(itemId, name, qty, price);
-                    }
-                }
-            }
+    for_each_row(path + "/items.txt", mode, [&](const Row &cols) {
+        int sellerId, itemId, qty;
+        Money price;
+        if (cols.size() < 5 || !parse(cols[0], sellerId) || !parse(cols[1], itemId)
+            || !parse(cols[3], qty) || !parse(cols[4], price)) return;
+        if (seller* s = state.findSeller(sellerId)) {
+            state.addItem(*s, itemId, cols[2], qty, price);
         }
-    }
+    });
 
     return any;
 }
 
+LoadResult load_all(AppState& state, const std::string& path, LoadMode mode) {
+    bool any;
+    if (detect_format(path) == Format::BINARY) {
+        // Starting from nothing and compacting later would replace the whole
+        // database with the journal's tail, so a bad snapshot stops here.
+        if (!load_binary(state, path)) {
+            state.snapshotCorrupt = true;
+            return LoadResult::CORRUPT;
+        }
+        any = true;
+    } else {
+        any = load_text(state, path, mode);
+    }
+    // What just came from the snapshot is already on disk; replayed changes are not
+    state.clearDirty();
+    state.reindexOrders();
+
+    // Mutations made after the snapshot was written
+    if (Journal::replay(state, path) > 0) any = true;
+    // Reservations are not stored; they are whatever the pending orders hold
+    state.recountReserved();
+    // Sales figures are derived from the order history, never stored
+    state.sales.rebuild(state.transactions);
+
+    return any ? LoadResult::LOADED : LoadResult::EMPTY;
+}
+
 } // namespace store
@@ -2,29 +2,32 @@
 #define PERSISTENCE_H
 
 #include <string>
+#include <string_view>
 #include <vector>
 #include <memory>
-#include "buyer.h"
-#include "seller.h"
-#include "bank_customer.h"
-#include "transaction.h"
+#include "app_state.h"
+#include "snapshot.h"
 
 
 using namespace std;
 
-struct AppState {
-    vector<Buyer> buyers;
-    vector<seller> sellers;
-    vector<unique_ptr<BankCustomer>> bankAccounts;
-    vector<Transaction> transactions;
-    vector<Transaction> pendingOrders;
-};
-
 
 namespace store {
+    // STREAM reads tables line by line; MAPPED maps each file and tokenizes it in place.
+    enum class LoadMode { STREAM, MAPPED };
+    // EMPTY: nothing on disk yet. CORRUPT: snapshot.bin exists but cannot be
+    // read; the state stays empty and the journal is not replayed over it.
+    enum class LoadResult { EMPTY, LOADED, CORRUPT };
+
     bool ensure_data_dir(const string &path = "data");
-    bool save_all(const AppState &state, const string &path = "data");
-    bool load_all(AppState &state, const string &path = "data");
+    bool save_all(const AppState &state, const string &path = "data", Format format = Format::TEXT);
+    // Loads snapshot.bin if present, otherwise the text tables, then replays the journal.
+    LoadResult load_all(AppState &state, const string &path = "data", LoadMode mode = LoadMode::MAPPED);
+    // Syncs tmp, renames it over file and syncs the directory, so once this
+    // returns true the new contents survive a power loss.
+    bool replace_file(const string &tmp, const string &file);
+    string safe(string_view s);
+    vector<string> split_fields(const string &line);
 }
 
 #endif // PERSISTENCE_H
\ No newline at end of file
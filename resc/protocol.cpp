@@ -0,0 +1,339 @@
+#include "protocol.h"
+#include "market.h"
+#include "catalog_query.h"
+#include "persistence.h"
+#include <charconv>
+#include <mutex>
+#include <shared_mutex>
+#include <vector>
+
+using namespace std;
+
+namespace protocol {
+
+using Shared = shared_lock<shared_mutex>;
+
+static void split(string_view line, char sep, vector<string_view> &out) {
+    out.clear();
+    size_t start = 0;
+    while (true) {
+        size_t end = line.find(sep, start);
+        if (end == string_view::npos) {
+            out.push_back(line.substr(start));
+            return;
+        }
+        out.push_back(line.substr(start, end - start));
+        start = end + 1;
+    }
+}
+
+template <typename T>
+static bool parse(string_view tok, T &out) {
+    const char *end = tok.data() + tok.size();
+    auto r = from_chars(tok.data(), end, out);
+    return r.ec == errc() && r.ptr == end;
+}
+
+static string money(Money amount) {
+    return amount.toString();
+}
+
+// Builds one OK response; rows are appended as they are produced.
+class Reply {
+    string &out;
+    size_t countAt;
+    size_t rows = 0;
+public:
+    explicit Reply(string &out) : out(out) {
+        out += "OK|";
+        countAt = out.size();
+        out += "\n";
+    }
+    ~Reply() { out.insert(countAt, to_string(rows)); }
+    Reply(const Reply&) = delete;
+    Reply& operator=(const Reply&) = delete;
+
+    void row(const string &line) {
+        out += line;
+        out += '\n';
+        ++rows;
+    }
+};
+
+static void fail(string &out, market::Status status) {
+    out += "ERR|";
+    out += market::statusName(status);
+    out += '\n';
+}
+
+static void done(string &out, market::Status status) {
+    if (status == market::OK) Reply ok(out);
+    else fail(out, status);
+}
+
+void handle(AppState &state, store::Journal &journal, Session &session, string_view line, string &out) {
+    if (!line.empty() && line.back() == '\r') line.remove_suffix(1);
+    vector<string_view> args;
+    split(line, '|', args);
+    string_view cmd = args[0];
+    size_t argc = args.size() - 1;
+    auto text = [&](size_t i) { return string(args[i]); };
+
+    if (cmd == "QUIT") {
+        session.closed = true;
+        Reply ok(out);
+        return;
+    }
+
+    if (cmd == "REGISTER") {
+        if (argc != 4) return fail(out, market::INVALID);
+        int id = 0;
+        market::Status st = market::registerBuyer(state, journal, text(1), text(2), text(3), text(4), id);
+        if (st != market::OK) return fail(out, st);
+        Reply(out).row(to_string(id));
+        return;
+    }
+
+    if (cmd == "LOGIN") {
+        int id = 0;
+        if (argc != 2 || !parse(args[1], id)) return fail(out, market::INVALID);
+        Shared lock(state.structure);
+        Buyer *b = state.findBuyer(id);
+        if (!b || b->getName() != args[2]) return fail(out, market::NOT_FOUND);
+        session.buyerId = id;
+        if (const seller *s = state.findSellerByBuyer(id)) {
+            Reply(out).row("SELLER|" + to_string(id) + "|" + to_string(s->getSellerId()) + "|" + store::safe(s->getStoreName()));
+        } else {
+            Reply(out).row("BUYER|" + to_string(id) + "|" + store::safe(b->getName()));
+        }
+        return;
+    }
+
+    if (cmd == "STORES") {
+        Shared lock(state.structure);
+        Reply ok(out);
+        for (const auto &s : state.sellers) {
+            ok.row(to_string(s.getSellerId()) + "|" + store::safe(s.getStoreName()));
+        }
+        return;
+    }
+
+    if (cmd == "ITEMS") {
+        int sellerId = 0;
+        if (argc != 1 || !parse(args[1], sellerId)) return fail(out, market::INVALID);
+        Shared lock(state.structure);
+        if (!state.findSeller(sellerId)) return fail(out, market::NOT_FOUND);
+        Reply ok(out);
+        for (const auto &item : state.items(sellerId)) {
+            ok.row(to_string(item.getId()) + "|" + store::safe(item.getName()) + "|" +
+                   to_string(item.getQuantity()) + "|" + money(item.getPrice()) + "|" + to_string(item.getReserved()));
+        }
+        return;
+    }
+
+    if (cmd == "FIND") {
+        query::ItemFilter filter;
+        if (argc != 2 || !Money::parse(args[1], filter.maxPrice) || !parse(args[2], filter.minQuantity)) {
+            return fail(out, market::INVALID);
+        }
+        Shared lock(state.structure);
+        const Catalog &c = state.catalog;
+        Reply ok(out);
+        for (uint32_t row : query::select(c, filter)) {
+            ok.row(to_string(c.sellerId(row)) + "|" + to_string(c.itemId(row)) + "|" + store::safe(c.name(row)) + "|" +
+                   to_string(c.quantity(row)) + "|" + money(c.price(row)));
+        }
+        return;
+    }
+
+    if (cmd == "SEARCH") {
+        if (argc != 1) return fail(out, market::INVALID);
+        Shared lock(state.structure);
+        Reply ok(out);
+        SearchResult found = state.search.search(args[1]);
+        for (const SearchHit &hit : found.hits) {
+            Item item = state.findItem(hit.sellerId, hit.itemId);
+            if (!item) continue;
+            ok.row(to_string(hit.sellerId) + "|" + to_string(hit.itemId) + "|" + store::safe(item.getName()) + "|" +
+                   to_string(item.getQuantity()) + "|" + money(item.getPrice()));
+        }
+        if (found.truncated) ok.row("TRUNCATED");
+        return;
+    }
+
+    if (cmd == "SOLD_OUT") {
+        query::ItemFilter filter;
+        filter.maxQuantity = 0;
+        Shared lock(state.structure);
+        Reply ok(out);
+        for (int id : query::sellersWith(state.catalog, filter)) {
+            if (const seller *s = state.findSeller(id)) ok.row(to_string(id) + "|" + store::safe(s->getStoreName()));
+        }
+        return;
+    }
+
+    // Everything below acts on behalf of the logged-in user
+    int buyerId = session.buyerId;
+    int sellerId = 0;
+    {
+        Shared lock(state.structure);
+        if (!buyerId || !state.findBuyer(buyerId)) {
+            session.buyerId = 0;
+            return fail(out, market::NOT_LOGGED_IN);
+        }
+        if (const seller *self = state.findSellerByBuyer(buyerId)) sellerId = self->getSellerId();
+    }
+
+    if (cmd == "LOGOUT") {
+        session.buyerId = 0;
+        Reply ok(out);
+        return;
+    }
+
+    if (cmd == "STATUS") {
+        Shared lock(state.structure);
+        const Buyer *buyer = state.findBuyer(buyerId);
+        if (!buyer) return fail(out, market::NOT_LOGGED_IN);
+        Reply ok(out);
+        ok.row(to_string(buyer->getId()) + "|" + store::safe(buyer->getName()) + "|" + store::safe(buyer->getEmail()) +
+               "|" + store::safe(buyer->getPhone()) + "|" + store::safe(buyer->getAddress()));
+        if (const BankCustomer *acc = state.accountOf(*buyer); acc && acc->getId() != 0) {
+            RowLocks::Guard row = state.rowLocks.lock({{RowKind::ACCOUNT, acc->getId()}});
+            ok.row("ACCOUNT|" + money(acc->getBalance()) + "|" + (acc->isDormant() ? "DORMANT" : "ACTIVE"));
+        }
+        if (const seller *self = state.findSellerByBuyer(buyerId)) {
+            ok.row("SELLER|" + to_string(self->getSellerId()) + "|" + store::safe(self->getStoreName()));
+        }
+        return;
+    }
+
+    if (cmd == "OPEN_ACCOUNT" || cmd == "TOPUP") {
+        Money amount;
+        if (argc != 1 || !Money::parse(args[1], amount)) return fail(out, market::INVALID);
+        return done(out, cmd == "TOPUP" ? market::topUp(state, journal, buyerId, amount)
+                                        : market::openAccount(state, journal, buyerId, amount));
+    }
+
+    if (cmd == "ORDER") {
+        int storeId = 0;
+        if (argc != 2 || !parse(args[1], storeId)) return fail(out, market::INVALID);
+        vector<string_view> entries, pair;
+        vector<market::OrderLine> lines;
+        split(args[2], ',', entries);
+        for (string_view entry : entries) {
+            split(entry, ':', pair);
+            market::OrderLine ol{};
+            if (pair.size() != 2 || !parse(pair[0], ol.itemId) || !parse(pair[1], ol.quantity)) {
+                return fail(out, market::INVALID);
+            }
+            lines.push_back(ol);
+        }
+        int id = 0;
+        market::Status st = market::placeOrder(state, journal, buyerId, storeId, lines, id);
+        if (st != market::OK) return fail(out, st);
+        optional<Transaction> placed = market::findPendingOrder(state, id);
+        if (!placed) return fail(out, market::NOT_FOUND);
+        Reply(out).row(to_string(id) + "|" + money(placed->getTotalAmount()));
+        return;
+    }
+
+    // Listings take an optional offset|limit, newest first
+    size_t offset = 0, limit = SIZE_MAX;
+    bool paged = argc == 0 || (argc == 2 && parse(args[1], offset) && parse(args[2], limit));
+
+    if (cmd == "PENDING") {
+        if (!paged) return fail(out, market::INVALID);
+        Reply ok(out);
+        for (const Transaction &t : market::pendingOrdersForBuyer(state, buyerId, offset, limit).orders) {
+            ok.row(to_string(t.getTransactionId()) + "|" + store::safe(t.getSellerName()) + "|" + money(t.getTotalAmount()));
+        }
+        return;
+    }
+
+    if (cmd == "HISTORY") {
+        if (!paged) return fail(out, market::INVALID);
+        Reply ok(out);
+        for (const Transaction &t : market::ordersForBuyer(state, buyerId, offset, limit).orders) {
+            ok.row(to_string(t.getTransactionId()) + "|" + store::safe(t.getSellerName()) + "|" +
+                   money(t.getTotalAmount()) + "|" + t.getStatusString() + "|" + t.getDate());
+        }
+        return;
+    }
+
+    if (cmd == "PAY") {
+        int id = 0;
+        if (argc != 1 || !parse(args[1], id)) return fail(out, market::INVALID);
+        Money balance;
+        market::Status st = market::payOrder(state, journal, buyerId, id, balance);
+        if (st != market::OK) return fail(out, st);
+        Reply(out).row(money(balance));
+        return;
+    }
+
+    if (cmd == "CANCEL") {
+        int id = 0;
+        if (argc != 1 || !parse(args[1], id)) return fail(out, market::INVALID);
+        return done(out, market::cancelOrder(state, journal, buyerId, id));
+    }
+
+    if (cmd == "UPGRADE") {
+        if (argc != 1 || args[1].empty()) return fail(out, market::INVALID);
+        int id = 0;
+        market::Status st = market::upgradeToSeller(state, journal, buyerId, text(1), id);
+        if (st != market::OK) return fail(out, st);
+        Reply(out).row(to_string(id));
+        return;
+    }
+
+    if (cmd == "DELETE") {
+        market::Status st = market::deleteUser(state, journal, buyerId);
+        session.buyerId = 0;
+        return done(out, st);
+    }
+
+    // Seller operations
+    if (cmd == "ADD_ITEM" || cmd == "REMOVE_ITEM" || cmd == "ORDERS" || cmd == "SALES") {
+        if (!sellerId) return fail(out, market::NOT_A_SELLER);
+
+        if (cmd == "ADD_ITEM") {
+            int itemId = 0, qty = 0;
+            Money price;
+            if (argc != 4 || !parse(args[1], itemId) || !parse(args[3], qty) || !Money::parse(args[4], price)) {
+                return fail(out, market::INVALID);
+            }
+            return done(out, market::addItem(state, journal, sellerId, itemId, text(2), qty, price));
+        }
+        if (cmd == "REMOVE_ITEM") {
+            int itemId = 0;
+            if (argc != 1 || !parse(args[1], itemId)) return fail(out, market::INVALID);
+            return done(out, market::removeItem(state, journal, sellerId, itemId));
+        }
+        if (cmd == "SALES") {
+            analytics::Report report = market::salesReport(state, sellerId);
+            Reply ok(out);
+            auto period = [&ok](const char *name, const analytics::Totals &t) {
+                ok.row(string(name) + "|" + money(t.revenue) + "|" + to_string(t.orders) + "|" + to_string(t.units));
+            };
+            period("ALL", report.allTime);
+            period("TODAY", report.today);
+            period("7D", report.last7Days);
+            period("30D", report.last30Days);
+            for (const analytics::ItemSales &item : report.topItems) {
+                ok.row("ITEM|" + to_string(item.itemId) + "|" + store::safe(item.name) + "|" +
+                       to_string(item.units) + "|" + money(item.revenue));
+            }
+            return;
+        }
+        if (!paged) return fail(out, market::INVALID);
+        Reply ok(out);
+        for (const Transaction &t : market::ordersForSeller(state, sellerId, offset, limit).orders) {
+            ok.row(to_string(t.getTransactionId()) + "|" + store::safe(t.getBuyerName()) + "|" +
+                   money(t.getTotalAmount()) + "|" + t.getStatusString() + "|" + t.getDate());
+        }
+        return;
+    }
+
+    fail(out, market::INVALID);
+}
+
+}
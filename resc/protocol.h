@@ -0,0 +1,52 @@
+#ifndef PROTOCOL_H
+#define PROTOCOL_H
+
+#include <string>
+#include <string_view>
+#include "app_state.h"
+#include "journal.h"
+
+using namespace std;
+
+// Line-based request/response protocol over the market operations, used by
+// market_server and loadgen. Fields are '|' separated, like the data files.
+//
+//   request  : COMMAND|arg|arg...\n
+//   response : OK|n\n followed by n data lines, or ERR|STATUS\n
+//
+//   LOGIN|id|name            -> BUYER|id|name  or  SELLER|id|sellerId|storeName
+//   REGISTER|name|email|phone|address -> buyerId
+//   LOGOUT, QUIT, STATUS, DELETE
+//   OPEN_ACCOUNT|deposit     TOPUP|amount
+//   STORES                   -> sellerId|storeName per store
+//   ITEMS|sellerId           -> itemId|name|available|price|reserved per item
+//   FIND|maxPrice|minQty     -> sellerId|itemId|name|available|price, every store
+//   SEARCH|text              -> sellerId|itemId|name|available|price, first 50 matches
+//                               then TRUNCATED if other items matched too
+//   SOLD_OUT                 -> sellerId|storeName per store with an item at 0 available
+//   ORDER|sellerId|itemId:qty,itemId:qty...  -> transactionId|total
+//   PENDING[|offset|limit]   -> transactionId|storeName|total per pending order
+//   HISTORY[|offset|limit]   -> transactionId|storeName|total|status|date per order
+//   PAY|transactionId        -> new balance
+//   CANCEL|transactionId     releases the order's reserved stock
+//   UPGRADE|storeName        -> sellerId
+//   ADD_ITEM|itemId|name|qty|price   REMOVE_ITEM|itemId
+//   ORDERS[|offset|limit]    -> transactionId|buyerName|total|status|date (seller only)
+//   Listings are newest first; offset|limit select one page of them.
+//   SALES                    -> ALL|TODAY|7D|30D rows of period|revenue|orders|units, then
+//                               ITEM|itemId|name|units|revenue per best seller (seller only)
+namespace protocol {
+
+// Per-connection state; the buyer id the connection logged in as, 0 if none.
+struct Session {
+    int buyerId = 0;
+    bool closed = false;
+};
+
+// Runs one request line (without the trailing newline) and appends the
+// response to `out`.
+void handle(AppState &state, store::Journal &journal, Session &session, string_view line, string &out);
+
+}
+
+#endif // PROTOCOL_H
@@ -0,0 +1,85 @@
+#ifndef ROW_LOCKS_H
+#define ROW_LOCKS_H
+
+#include <algorithm>
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <initializer_list>
+#include <mutex>
+
+using namespace std;
+
+// What a row lock protects; ids of different kinds never share a key.
+enum class RowKind : uint32_t {
+    ACCOUNT,  // a BankCustomer's balance
+    ORDER     // a pending order, while it is being paid or cancelled
+};
+
+struct RowKey {
+    RowKind kind;
+    int id;
+};
+
+// Striped mutexes for rows of AppState. A row maps to one of STRIPES mutexes
+// by hash, so unrelated rows rarely contend and memory stays fixed.
+//
+// Deadlock freedom: lock() takes every stripe a caller needs in one call, in
+// ascending stripe order, and nobody takes a stripe while already holding one
+// from an earlier lock(). Equal stripes are taken once.
+class RowLocks {
+public:
+    static constexpr size_t STRIPES = 256;
+    static constexpr size_t MAX_KEYS = 4;
+
+    class Guard {
+        friend class RowLocks;
+        RowLocks *owner = nullptr;
+        array<size_t, MAX_KEYS> held{};
+        size_t count = 0;
+    public:
+        Guard() = default;
+        Guard(Guard &&other) noexcept : owner(other.owner), held(other.held), count(other.count) { other.count = 0; }
+        Guard(const Guard&) = delete;
+        Guard& operator=(const Guard&) = delete;
+        Guard& operator=(Guard&&) = delete;
+        ~Guard() { unlock(); }
+
+        void unlock() {
+            while (count > 0) owner->stripes[held[--count]].m.unlock();
+        }
+    };
+
+    // At most MAX_KEYS keys per call.
+    Guard lock(initializer_list<RowKey> keys) {
+        Guard g;
+        g.owner = this;
+        for (const RowKey &k : keys) {
+            if (g.count < MAX_KEYS) g.held[g.count++] = stripeOf(k);
+        }
+        sort(g.held.begin(), g.held.begin() + static_cast<ptrdiff_t>(g.count));
+        g.count = static_cast<size_t>(unique(g.held.begin(), g.held.begin() + static_cast<ptrdiff_t>(g.count)) - g.held.begin());
+        for (size_t i = 0; i < g.count; ++i) stripes[g.held[i]].m.lock();
+        return g;
+    }
+
+    static size_t stripeOf(RowKey k) {
+        uint64_t x = (static_cast<uint64_t>(k.kind) << 32) | static_cast<uint32_t>(k.id);
+        // splitmix64 finalizer, so sequential ids spread over the stripes
+        x ^= x >> 30;
+        x *= 0xbf58476d1ce4e5b9ULL;
+        x ^= x >> 27;
+        x *= 0x94d049bb133111ebULL;
+        x ^= x >> 31;
+        return static_cast<size_t>(x % STRIPES);
+    }
+
+private:
+    // One cache line per stripe so neighbouring stripes do not false-share
+    struct alignas(64) Stripe {
+        mutex m;
+    };
+    array<Stripe, STRIPES> stripes;
+};
+
+#endif // ROW_LOCKS_H
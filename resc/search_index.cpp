@@ -0,0 +1,201 @@
+#include "search_index.h"
+#include "app_state.h"
+#include <algorithm>
+#include <queue>
+#include <unordered_set>
+
+using namespace std;
+
+static bool isWordByte(unsigned char c) {
+    return (c >= '0' && c <= '9') || (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z') || c >= 0x80;
+}
+
+vector<string> SearchIndex::tokenize(string_view text) {
+    vector<string> tokens;
+    string word;
+    for (char ch : text) {
+        unsigned char c = static_cast<unsigned char>(ch);
+        if (isWordByte(c)) {
+            word += (c >= 'A' && c <= 'Z') ? static_cast<char>(c - 'A' + 'a') : ch;
+        } else if (!word.empty()) {
+            tokens.push_back(move(word));
+            word.clear();
+        }
+    }
+    if (!word.empty()) tokens.push_back(move(word));
+    return tokens;
+}
+
+// Each word once, so a name like "cable cable" posts its item once.
+static vector<string> distinctWords(string_view text) {
+    vector<string> tokens = SearchIndex::tokenize(text);
+    sort(tokens.begin(), tokens.end());
+    tokens.erase(unique(tokens.begin(), tokens.end()), tokens.end());
+    return tokens;
+}
+
+size_t SearchIndex::editDistance(string_view a, string_view b, size_t max) {
+    if (a.size() > b.size()) swap(a, b);
+    if (b.size() - a.size() > max) return max + 1;
+    vector<size_t> prev(a.size() + 1), cur(a.size() + 1);
+    for (size_t i = 0; i <= a.size(); i++) prev[i] = i;
+    for (size_t j = 1; j <= b.size(); j++) {
+        cur[0] = j;
+        size_t best = cur[0];
+        for (size_t i = 1; i <= a.size(); i++) {
+            size_t sub = prev[i - 1] + (a[i - 1] == b[j - 1] ? 0 : 1);
+            cur[i] = min({sub, prev[i] + 1, cur[i - 1] + 1});
+            best = min(best, cur[i]);
+        }
+        if (best > max) return max + 1;
+        swap(prev, cur);
+    }
+    return min(prev[a.size()], max + 1);
+}
+
+// The word with each letter removed in turn, without repeats.
+static vector<string> oneDeleted(const string& word) {
+    vector<string> variants;
+    for (size_t i = 0; i < word.size(); i++) {
+        string v = word.substr(0, i) + word.substr(i + 1);
+        if (find(variants.begin(), variants.end(), v) == variants.end()) variants.push_back(move(v));
+    }
+    return variants;
+}
+
+void SearchIndex::link(const string& word) {
+    for (string& v : oneDeleted(word)) deletes[move(v)].push_back(&word);
+}
+
+void SearchIndex::unlink(const string& word) {
+    for (const string& v : oneDeleted(word)) {
+        auto it = deletes.find(v);
+        if (it == deletes.end()) continue;
+        auto& from = it->second;
+        from.erase(std::remove(from.begin(), from.end(), &word), from.end());
+        if (from.empty()) deletes.erase(it);
+    }
+}
+
+void SearchIndex::add(int sellerId, int itemId, string_view name) {
+    uint64_t key = AppState::itemKey(sellerId, itemId);
+    for (string& token : distinctWords(name)) {
+        auto [it, added] = words.try_emplace(move(token));
+        if (added) link(it->first);
+        auto& items = it->second;
+        // Loading adds in key order, so this is nearly always an append
+        auto at = lower_bound(items.begin(), items.end(), key);
+        if (at == items.end() || *at != key) items.insert(at, key);
+    }
+}
+
+void SearchIndex::remove(int sellerId, int itemId, string_view name) {
+    uint64_t key = AppState::itemKey(sellerId, itemId);
+    for (const string& token : distinctWords(name)) {
+        auto it = words.find(token);
+        if (it == words.end()) continue;
+        auto& items = it->second;
+        auto at = lower_bound(items.begin(), items.end(), key);
+        if (at != items.end() && *at == key) items.erase(at);
+        if (items.empty()) {
+            unlink(it->first);
+            words.erase(it);
+        }
+    }
+}
+
+void SearchIndex::clear() {
+    words.clear();
+    deletes.clear();
+}
+
+bool SearchIndex::expand(const string& word, vector<const vector<uint64_t>*>& lists) const {
+    for (auto it = words.lower_bound(word); it != words.end(); ++it) {
+        if (it->first.compare(0, word.size(), word) != 0) break;
+        if (lists.size() == MAX_EXPANSIONS) return false;
+        lists.push_back(&it->second);
+    }
+    if (!lists.empty()) return true;
+
+    // No word starts with it; try words one edit away. Such a word equals the
+    // query minus a letter, or the two share a one-letter-deleted variant.
+    unordered_set<const string*> near;
+    auto collect = [&](const string& variant) {
+        auto it = deletes.find(variant);
+        if (it != deletes.end()) near.insert(it->second.begin(), it->second.end());
+    };
+    collect(word);
+    for (const string& v : oneDeleted(word)) {
+        if (auto it = words.find(v); it != words.end()) near.insert(&it->first);
+        collect(v);
+    }
+    for (const string* candidate : near) {
+        if (editDistance(word, *candidate, 1) > 1) continue;
+        if (lists.size() == MAX_EXPANSIONS) return false;
+        lists.push_back(&words.find(*candidate)->second);
+    }
+    return true;
+}
+
+// Sorted union of posting lists, merged a key at a time so a search stops
+// reading them once it has enough hits.
+class Union {
+    using Head = pair<uint64_t, size_t>;  // (next key, list index)
+    const vector<const vector<uint64_t>*>& lists;
+    vector<size_t> pos;
+    priority_queue<Head, vector<Head>, greater<Head>> heads;
+    bool started = false;
+    uint64_t last = 0;
+
+public:
+    explicit Union(const vector<const vector<uint64_t>*>& lists) : lists(lists), pos(lists.size(), 0) {
+        for (size_t i = 0; i < lists.size(); i++) if (!lists[i]->empty()) heads.emplace((*lists[i])[0], i);
+    }
+
+    bool next(uint64_t& key) {
+        while (!heads.empty()) {
+            auto [k, i] = heads.top();
+            heads.pop();
+            if (++pos[i] < lists[i]->size()) heads.emplace((*lists[i])[pos[i]], i);
+            if (started && k == last) continue;
+            started = true;
+            key = last = k;
+            return true;
+        }
+        return false;
+    }
+};
+
+static size_t totalSize(const vector<const vector<uint64_t>*>& lists) {
+    size_t n = 0;
+    for (const auto* l : lists) n += l->size();
+    return n;
+}
+
+SearchResult SearchIndex::search(string_view query, size_t limit) const {
+    SearchResult result;
+    vector<string> tokens = distinctWords(query);
+    if (tokens.empty() || limit == 0) return result;
+
+    vector<vector<const vector<uint64_t>*>> perWord(tokens.size());
+    for (size_t i = 0; i < tokens.size(); i++) {
+        if (!expand(tokens[i], perWord[i])) result.truncated = true;
+        if (perWord[i].empty()) return SearchResult();
+    }
+    // Walk the rarest word's items and keep those every other word also has,
+    // looking one match past the limit to know whether any were left out
+    sort(perWord.begin(), perWord.end(), [](const auto& a, const auto& b) { return totalSize(a) < totalSize(b); });
+    Union keys(perWord[0]);
+    for (uint64_t key; keys.next(key);) {
+        bool all = all_of(perWord.begin() + 1, perWord.end(), [key](const auto& lists) {
+            return any_of(lists.begin(), lists.end(), [key](const auto* l) { return binary_search(l->begin(), l->end(), key); });
+        });
+        if (!all) continue;
+        if (result.hits.size() == limit) {
+            result.truncated = true;
+            break;
+        }
+        result.hits.push_back({static_cast<int>(key >> 32), static_cast<int>(static_cast<uint32_t>(key))});
+    }
+    return result;
+}
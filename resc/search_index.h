@@ -0,0 +1,75 @@
+#ifndef SEARCH_INDEX_H
+#define SEARCH_INDEX_H
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+struct SearchHit {
+    int sellerId;
+    int itemId;
+};
+
+struct SearchResult {
+    vector<SearchHit> hits;
+    // More items matched than the limit, or a query word matched more than
+    // MAX_EXPANSIONS words and the rest were not looked at.
+    bool truncated = false;
+};
+
+// Inverted index over item names across all sellers.
+//
+// Names are split into lowercase words at anything that is not a letter or
+// digit (bytes >= 0x80 count as letters, so UTF-8 words stay whole). Every
+// word of a query must match a word of the name, where "matches" means the
+// query word is a prefix of it, or, if no name word has that prefix, is
+// within one edit (insert, delete or substitute) of it.
+//
+// Words are kept in an ordered map, so a prefix is one contiguous range of
+// it. Fuzzy lookups go through a table of each word with one letter deleted:
+// two words within one edit always share such a variant.
+//
+// Updated by the AppState item helpers; lookups need AppState::structure
+// held at least shared, updates exclusively.
+class SearchIndex {
+public:
+    static constexpr size_t DEFAULT_LIMIT = 50;
+    // Words a query word may expand to by prefix or edit, whether it is the
+    // only word of the query or one of several. The rest are ignored, which
+    // bounds the cost of very short queries, and the result is truncated.
+    static constexpr size_t MAX_EXPANSIONS = 256;
+
+    void add(int sellerId, int itemId, string_view name);
+    void remove(int sellerId, int itemId, string_view name);
+    void clear();
+
+    // Items matching every word of `query`, ordered by seller then item id,
+    // at most `limit` of them.
+    SearchResult search(string_view query, size_t limit = DEFAULT_LIMIT) const;
+
+    size_t wordCount() const { return words.size(); }
+
+    static vector<string> tokenize(string_view text);
+    // Levenshtein distance, or max + 1 once it is known to exceed max.
+    static size_t editDistance(string_view a, string_view b, size_t max);
+
+private:
+    // word -> items containing it, sorted by AppState::itemKey
+    map<string, vector<uint64_t>, less<>> words;
+    // word with one letter removed -> words it came from
+    unordered_map<string, vector<const string*>> deletes;
+
+    void link(const string& word);
+    void unlink(const string& word);
+    // Posting lists a query word expands to; false if it stopped at
+    // MAX_EXPANSIONS with more words left.
+    bool expand(const string& word, vector<const vector<uint64_t>*>& lists) const;
+};
+
+#endif // SEARCH_INDEX_H
@@ -1,49 +1,27 @@
 // seller.h
 #pragma once
-#include "buyer.h"
-#include "item.h"
-#include <string>
-#include <vector>
+#include <string_view>
+#include "slot_map.h"
+#include "symbols.h"
 
 using namespace std;
 
-class seller : public Buyer {
+// A user's storefront. The profile (name, contact details, bank account)
+// stays on the user's Buyer record; this only adds what selling needs and
+// points back at the user by id.
+class seller {
 private:
+    int userId;
     int sellerId;
-    string sellerName;
-    vector<Item> items;
-
-    bool idDisplayed(int itemId) const {
-        return itemId > 0;
-    }
+    symbols::Id sellerName;
 public:
-    seller() = default;
-        seller(const Buyer& buyer, int sellerId, const string& sellerName)
-        : Buyer(buyer.getId(), buyer.getName(), buyer.getEmail(), buyer.getPhone(), buyer.getAddress(), buyer.getAccount()),
-          sellerId(sellerId), sellerName(sellerName) {}
-    virtual ~seller() = default;
+    seller(int userId, int sellerId, string_view sellerName)
+        : userId(userId), sellerId(sellerId), sellerName(symbols::intern(sellerName)) {}
+    // The owning user's buyer id.
+    int getUserId() const { return userId; }
     int getSellerId() const { return sellerId; }
-    const string& getStoreName() const { return sellerName; }
-    const vector<Item>& getItems() const { return items; }
-    vector<Item>& getItems() { return items; } 
-    void addNewItem(int newId, const string& newName, int newQuantity, double newPrice) {
-        Item newItem(newId, newName, newQuantity, newPrice);
-        items.push_back(newItem);
-    }
-    void updateItem(int itemId, const string& newName, int newQuantity, double newPrice) {
-        for (auto& item : items) {
-            if (item.getId() == itemId) {
-                item = Item(itemId, newName, newQuantity, newPrice); 
-                break;
-            }
-        }
-    }
-    void makeItemVisibleToCustomer(int itemId) {
-        for (auto& item : items) {
-            if (item.getId() == itemId) {
-                item.setDisplay(true);
-                break;
-            }
-        }
-    }
-};
\ No newline at end of file
+    string_view getStoreName() const { return symbols::view(sellerName); }
+    symbols::Id getStoreNameId() const { return sellerName; }
+};
+
+using SellerHandle = Handle<seller>;
@@ -0,0 +1,138 @@
+#ifndef SLOT_MAP_H
+#define SLOT_MAP_H
+
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <optional>
+#include <utility>
+#include <vector>
+
+using namespace std;
+
+// A reference to an entry of a SlotMap<T>. It names one slot and the
+// generation the entry was created in, so once the entry is erased the
+// handle stops resolving instead of pointing at whatever reuses the slot.
+// A default-constructed handle never resolves.
+template <typename T>
+struct Handle {
+    uint32_t index = 0;
+    uint32_t generation = 0;
+
+    explicit operator bool() const { return generation != 0; }
+    bool operator==(const Handle&) const = default;
+};
+
+// Generational slot map: entries live in fixed-size blocks that never move,
+// so both handles and pointers stay valid while the entry exists. Erased
+// slots are reused, newest first, with their generation bumped.
+// Not thread-safe: the owner serializes insert/erase against readers.
+template <typename T, size_t BLOCK = 256>
+class SlotMap {
+    struct Slot {
+        optional<T> value;
+        uint32_t generation = 1;
+    };
+
+public:
+    SlotMap() = default;
+    SlotMap(const SlotMap&) = delete;
+    SlotMap& operator=(const SlotMap&) = delete;
+
+    template <typename... Args>
+    Handle<T> insert(Args&&... args) {
+        uint32_t index;
+        if (!freeSlots.empty()) {
+            index = freeSlots.back();
+            freeSlots.pop_back();
+        } else {
+            if (capacity == blocks.size() * BLOCK) blocks.push_back(make_unique<Slot[]>(BLOCK));
+            index = static_cast<uint32_t>(capacity++);
+        }
+        Slot& s = slot(index);
+        s.value.emplace(std::forward<Args>(args)...);
+        count++;
+        return {index, s.generation};
+    }
+
+    // nullptr once the entry has been erased.
+    T* get(Handle<T> h) {
+        if (h.index >= capacity) return nullptr;
+        Slot& s = slot(h.index);
+        return s.generation == h.generation && s.value ? &*s.value : nullptr;
+    }
+    const T* get(Handle<T> h) const {
+        if (h.index >= capacity) return nullptr;
+        const Slot& s = slot(h.index);
+        return s.generation == h.generation && s.value ? &*s.value : nullptr;
+    }
+
+    bool erase(Handle<T> h) {
+        if (!get(h)) return false;
+        Slot& s = slot(h.index);
+        s.value.reset();
+        // Generation 0 is the null handle's
+        if (++s.generation == 0) s.generation = 1;
+        freeSlots.push_back(h.index);
+        count--;
+        return true;
+    }
+
+    void clear() {
+        for (size_t i = 0; i < capacity; i++) {
+            Slot& s = slot(static_cast<uint32_t>(i));
+            if (s.value) erase({static_cast<uint32_t>(i), s.generation});
+        }
+    }
+
+    size_t size() const { return count; }
+    bool empty() const { return count == 0; }
+    // Makes room for n entries in total without allocating while inserting.
+    void reserve(size_t n) {
+        while (blocks.size() * BLOCK < n) blocks.push_back(make_unique<Slot[]>(BLOCK));
+    }
+
+    // Visits live entries in slot order, which is insertion order until
+    // slots start being reused. handle() names the current entry.
+    template <typename M, typename V>
+    class Iter {
+    public:
+        Iter(M* map, size_t i) : map(map), i(i) { skip(); }
+        V& operator*() const { return *map->slot(static_cast<uint32_t>(i)).value; }
+        V* operator->() const { return &**this; }
+        Iter& operator++() {
+            i++;
+            skip();
+            return *this;
+        }
+        bool operator!=(const Iter& other) const { return i != other.i; }
+        Handle<T> handle() const {
+            return {static_cast<uint32_t>(i), map->slot(static_cast<uint32_t>(i)).generation};
+        }
+
+    private:
+        M* map;
+        size_t i;
+        void skip() {
+            while (i < map->capacity && !map->slot(static_cast<uint32_t>(i)).value) i++;
+        }
+    };
+    using iterator = Iter<SlotMap, T>;
+    using const_iterator = Iter<const SlotMap, const T>;
+
+    iterator begin() { return iterator(this, 0); }
+    iterator end() { return iterator(this, capacity); }
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, capacity); }
+
+private:
+    vector<unique_ptr<Slot[]>> blocks;
+    vector<uint32_t> freeSlots;
+    size_t capacity = 0;   // slots handed out so far
+    size_t count = 0;      // of which live
+
+    Slot& slot(uint32_t index) { return blocks[index / BLOCK][index % BLOCK]; }
+    const Slot& slot(uint32_t index) const { return blocks[index / BLOCK][index % BLOCK]; }
+};
+
+#endif // SLOT_MAP_H
@@ -0,0 +1,412 @@
+#include <cstdint>
+#include <cstring>
+#include <filesystem>
+#include <fstream>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <vector>
+
+#include "snapshot.h"
+#include "persistence.h"
+#include "mapped_file.h"
+
+namespace fs = std::filesystem;
+
+namespace store {
+
+static const char MAGIC[8] = {'M', 'K', 'T', 'S', 'N', 'A', 'P', '\0'};
+// Version 2 stores amounts as i64 cents, version 3 dates as i32 days
+// (dt::Day) and version 4 names as i32 indexes into a T_SYMBOLS table.
+// Older files (f64 amounts, text dates and names) still load.
+static const uint32_t VERSION = 4;
+
+enum ColumnType : uint32_t { COL_I32 = 1, COL_I64 = 2, COL_F64 = 3, COL_STR = 4 };
+enum TableId : uint32_t {
+    T_ACCOUNTS = 1, T_BUYERS = 2, T_SELLERS = 3, T_ITEMS = 4, T_TRANSACTIONS = 5,
+    T_PENDING_ORDERS = 6, T_TRANSACTION_ITEMS = 7, T_SYMBOLS = 8, T_JOURNAL = 9
+};
+
+// The names one snapshot uses, numbered in order of first use; written out
+// as the single string column of T_SYMBOLS.
+struct SymbolRefs {
+    std::unordered_map<symbols::Id, uint32_t> index;
+    std::vector<symbols::Id> used;
+
+    int32_t ref(symbols::Id id) {
+        auto [it, added] = index.try_emplace(id, static_cast<uint32_t>(used.size()));
+        if (added) used.push_back(id);
+        return static_cast<int32_t>(it->second);
+    }
+};
+
+static uint64_t fnv1a(std::string_view bytes) {
+    uint64_t h = 14695981039346656037ull;
+    for (unsigned char c : bytes) {
+        h ^= c;
+        h *= 1099511628211ull;
+    }
+    return h;
+}
+
+template <typename T>
+static void put(std::string &out, T v) {
+    char raw[sizeof(T)];
+    std::memcpy(raw, &v, sizeof(T));
+    out.append(raw, sizeof(T));
+}
+
+template <typename T>
+static T get(const char *p) {
+    T v;
+    std::memcpy(&v, p, sizeof(T));
+    return v;
+}
+
+// Accumulates one table column by column; get(r) supplies the value of row r.
+class TableBuilder {
+private:
+    uint32_t id;
+    uint64_t rows;
+    uint32_t columns;
+    std::string payload;
+
+    void begin(ColumnType type) {
+        put<uint32_t>(payload, type);
+        put<uint32_t>(payload, 0);
+        columns++;
+    }
+    void pad() {
+        while (payload.size() % 8) payload.push_back('\0');
+    }
+
+public:
+    TableBuilder(TableId id, size_t rows) : id(id), rows(rows), columns(0) {}
+
+    template <typename Fn> void i32(Fn get) {
+        begin(COL_I32);
+        for (size_t r = 0; r < rows; r++) put<int32_t>(payload, get(r));
+        pad();
+    }
+    template <typename Fn> void i64(Fn get) {
+        begin(COL_I64);
+        for (size_t r = 0; r < rows; r++) put<int64_t>(payload, get(r));
+        pad();
+    }
+    template <typename Fn> void money(Fn get) {
+        i64([&](size_t r) { return get(r).cents(); });
+    }
+    // Names, as indexes into the snapshot's symbol table.
+    template <typename Fn> void sym(SymbolRefs &refs, Fn get) {
+        i32([&](size_t r) { return refs.ref(get(r)); });
+    }
+    template <typename Fn> void str(Fn get) {
+        begin(COL_STR);
+        std::string heap;
+        put<uint32_t>(payload, 0);
+        for (size_t r = 0; r < rows; r++) {
+            heap += get(r);
+            put<uint32_t>(payload, static_cast<uint32_t>(heap.size()));
+        }
+        payload += heap;
+        pad();
+    }
+
+    void writeTo(std::string &out) const {
+        put<uint32_t>(out, id);
+        put<uint32_t>(out, columns);
+        put<uint64_t>(out, rows);
+        put<uint64_t>(out, payload.size());
+        put<uint64_t>(out, fnv1a(payload));
+        out += payload;
+    }
+};
+
+// The live entries of a slot map, so columns can be built by row number.
+template <typename T>
+static std::vector<const T *> rows_of(const SlotMap<T> &map) {
+    std::vector<const T *> rows;
+    rows.reserve(map.size());
+    for (const T &entry : map) rows.push_back(&entry);
+    return rows;
+}
+
+// Order headers; shared by the paid and pending tables.
+static void write_orders(std::string &out, SymbolRefs &names, TableId id, const OrderList &rows) {
+    TableBuilder t(id, rows.size());
+    t.i32([&](size_t r) { return rows[r].getTransactionId(); });
+    t.i32([&](size_t r) { return rows[r].getBuyerId(); });
+    t.sym(names, [&](size_t r) { return rows[r].getBuyerNameId(); });
+    t.i32([&](size_t r) { return rows[r].getSellerId(); });
+    t.sym(names, [&](size_t r) { return rows[r].getSellerNameId(); });
+    t.money([&](size_t r) { return rows[r].getTotalAmount(); });
+    t.i32([&](size_t r) { return static_cast<int>(rows[r].getStatus()); });
+    t.i32([&](size_t r) { return rows[r].getDay(); });
+    t.writeTo(out);
+}
+
+bool save_binary(const AppState &state, const std::string &path) {
+    if (!ensure_data_dir(path)) return false;
+    std::string out(MAGIC, sizeof(MAGIC));
+    put<uint32_t>(out, VERSION);
+    put<uint32_t>(out, 9);
+    SymbolRefs names;
+
+    {
+        // One row: AppState::coveredJournals. Older readers skip the table.
+        TableBuilder t(T_JOURNAL, 1);
+        t.i64([&](size_t) { return static_cast<int64_t>(state.coveredJournals); });
+        t.writeTo(out);
+    }
+
+    {
+        const auto rows = rows_of(state.bankAccounts);
+        TableBuilder t(T_ACCOUNTS, rows.size());
+        t.i32([&](size_t r) { return rows[r]->getId(); });
+        t.sym(names, [&](size_t r) { return rows[r]->getNameId(); });
+        t.money([&](size_t r) { return rows[r]->getBalance(); });
+        t.writeTo(out);
+    }
+    {
+        const auto rows = rows_of(state.buyers);
+        TableBuilder t(T_BUYERS, rows.size());
+        t.i32([&](size_t r) { return rows[r]->getId(); });
+        t.sym(names, [&](size_t r) { return rows[r]->getNameId(); });
+        t.str([&](size_t r) { return rows[r]->getEmail(); });
+        t.str([&](size_t r) { return rows[r]->getPhone(); });
+        t.str([&](size_t r) { return rows[r]->getAddress(); });
+        t.i32([&](size_t r) {
+            const BankCustomer *acc = state.accountOf(*rows[r]);
+            return (acc && acc->getId() != 0) ? 1 : 0;
+        });
+        t.writeTo(out);
+    }
+    {
+        const auto rows = rows_of(state.sellers);
+        TableBuilder t(T_SELLERS, rows.size());
+        t.i32([&](size_t r) { return rows[r]->getUserId(); });
+        t.i32([&](size_t r) { return rows[r]->getSellerId(); });
+        t.sym(names, [&](size_t r) { return rows[r]->getStoreNameId(); });
+        t.writeTo(out);
+    }
+    {
+        // Already columns; copied straight across
+        const Catalog &c = state.catalog;
+        TableBuilder t(T_ITEMS, c.size());
+        t.i32([&](size_t r) { return c.sellerId(r); });
+        t.i32([&](size_t r) { return c.itemId(r); });
+        t.sym(names, [&](size_t r) { return c.nameId(r); });
+        t.i32([&](size_t r) { return c.quantity(r); });
+        t.money([&](size_t r) { return c.price(r); });
+        t.writeTo(out);
+    }
+    write_orders(out, names, T_TRANSACTIONS, state.transactions);
+    write_orders(out, names, T_PENDING_ORDERS, state.pendingOrders);
+    {
+        std::vector<std::pair<int, const TransactionItem *>> rows;
+        for (const auto *orders : {&state.transactions, &state.pendingOrders}) {
+            for (const auto &t : *orders) {
+                for (const auto &item : t.getItems()) rows.emplace_back(t.getTransactionId(), &item);
+            }
+        }
+        TableBuilder t(T_TRANSACTION_ITEMS, rows.size());
+        t.i32([&](size_t r) { return rows[r].first; });
+        t.i32([&](size_t r) { return rows[r].second->getItemId(); });
+        t.sym(names, [&](size_t r) { return rows[r].second->getItemNameId(); });
+        t.i32([&](size_t r) { return rows[r].second->getQuantity(); });
+        t.money([&](size_t r) { return rows[r].second->getPricePerUnit(); });
+        t.writeTo(out);
+    }
+    {
+        // Last, once every table has added the names it refers to
+        TableBuilder t(T_SYMBOLS, names.used.size());
+        t.str([&](size_t r) { return symbols::view(names.used[r]); });
+        t.writeTo(out);
+    }
+
+    // Write beside the old snapshot and swap it in, so a crash never leaves a torn file.
+    std::string file = path + "/" + SNAPSHOT_FILE;
+    {
+        std::ofstream f(file + ".tmp", std::ios::binary | std::ios::trunc);
+        if (!f.write(out.data(), static_cast<std::streamsize>(out.size())) || !f.flush()) return false;
+    }
+    return replace_file(file + ".tmp", file);
+}
+
+// A column inside the mapped file. Accessors copy out with memcpy since the
+// mapping gives no alignment guarantee for callers on strict platforms.
+struct Column {
+    uint32_t type = 0;
+    const char *data = nullptr;
+    const char *heap = nullptr;
+
+    int32_t i32(size_t r) const { return get<int32_t>(data + r * 4); }
+    int64_t i64(size_t r) const { return get<int64_t>(data + r * 8); }
+    double f64(size_t r) const { return get<double>(data + r * 8); }
+    Money money(size_t r) const {
+        return type == COL_I64 ? Money::fromCents(i64(r)) : Money::fromDouble(f64(r));
+    }
+    dt::Day day(size_t r) const {
+        return type == COL_I32 ? i32(r) : dt::from_string(str(r));
+    }
+    std::string str(size_t r) const { return std::string(text(r)); }
+    std::string_view text(size_t r) const {
+        uint32_t a = get<uint32_t>(data + r * 4);
+        uint32_t b = get<uint32_t>(data + (r + 1) * 4);
+        return std::string_view(heap + a, b - a);
+    }
+    // A name: an index into the snapshot's symbols, or text before version 4.
+    symbols::Id sym(size_t r, const std::vector<symbols::Id> &names) const {
+        if (type != COL_I32) return symbols::intern(text(r));
+        uint32_t i = static_cast<uint32_t>(i32(r));
+        return i < names.size() ? names[i] : symbols::EMPTY;
+    }
+    std::string_view name(size_t r, const std::vector<symbols::Id> &names) const {
+        return symbols::view(sym(r, names));
+    }
+};
+
+struct Table {
+    uint32_t id = 0;
+    uint64_t rows = 0;
+    std::vector<Column> cols;
+};
+
+static size_t padded(size_t n) { return (n + 7) & ~static_cast<size_t>(7); }
+
+// Validates bounds and checksums while locating every column; nothing is copied.
+static bool parse_tables(std::string_view file, std::vector<Table> &tables) {
+    if (file.size() < 16 || std::memcmp(file.data(), MAGIC, sizeof(MAGIC)) != 0) return false;
+    uint32_t version = get<uint32_t>(file.data() + 8);
+    if (version < 1 || version > VERSION) return false;
+    uint32_t count = get<uint32_t>(file.data() + 12);
+    size_t pos = 16;
+    for (uint32_t i = 0; i < count; i++) {
+        if (file.size() - pos < 32) return false;
+        Table t;
+        t.id = get<uint32_t>(file.data() + pos);
+        uint32_t ncols = get<uint32_t>(file.data() + pos + 4);
+        t.rows = get<uint64_t>(file.data() + pos + 8);
+        uint64_t bytes = get<uint64_t>(file.data() + pos + 16);
+        uint64_t sum = get<uint64_t>(file.data() + pos + 24);
+        pos += 32;
+        if (bytes > file.size() - pos) return false;
+        std::string_view payload = file.substr(pos, bytes);
+        if (fnv1a(payload) != sum) return false;
+        pos += bytes;
+        if (t.rows > payload.size()) return false;
+
+        size_t at = 0;
+        for (uint32_t c = 0; c < ncols; c++) {
+            if (payload.size() - at < 8) return false;
+            Column col;
+            col.type = get<uint32_t>(payload.data() + at);
+            at += 8;
+            size_t need;
+            switch (col.type) {
+                case COL_I32: need = t.rows * 4; break;
+                case COL_I64:
+                case COL_F64: need = t.rows * 8; break;
+                case COL_STR: need = (t.rows + 1) * 4; break;
+                default: return false;
+            }
+            if (payload.size() - at < need) return false;
+            col.data = payload.data() + at;
+            at += need;
+            if (col.type == COL_STR) {
+                uint32_t prev = 0;
+                for (size_t r = 0; r <= t.rows; r++) {
+                    uint32_t off = get<uint32_t>(col.data + r * 4);
+                    if (off < prev) return false;
+                    prev = off;
+                }
+                if (payload.size() - at < prev) return false;
+                col.heap = payload.data() + at;
+                at += prev;
+            }
+            at = padded(at);
+            if (at > payload.size()) return false;
+            t.cols.push_back(col);
+        }
+        tables.push_back(std::move(t));
+    }
+    return true;
+}
+
+static const Table *find_table(const std::vector<Table> &tables, TableId id, size_t minCols) {
+    for (const auto &t : tables) if (t.id == id && t.cols.size() >= minCols) return &t;
+    return nullptr;
+}
+
+bool load_binary(AppState &state, const std::string &path) {
+    MappedFile mf(path + "/" + SNAPSHOT_FILE);
+    std::vector<Table> tables;
+    if (!mf.isOpen() || !parse_tables(mf.view(), tables)) return false;
+
+    // Snapshot symbol index -> this process's symbol id; empty before version 4
+    std::vector<symbols::Id> names;
+    if (const Table *t = find_table(tables, T_SYMBOLS, 1)) {
+        names.reserve(t->rows);
+        for (size_t r = 0; r < t->rows; r++) names.push_back(symbols::intern(t->cols[0].text(r)));
+    }
+
+    if (const Table *t = find_table(tables, T_JOURNAL, 1); t && t->rows == 1 && t->cols[0].type == COL_I64) {
+        state.coveredJournals = static_cast<uint64_t>(t->cols[0].i64(0));
+    }
+    if (const Table *t = find_table(tables, T_ACCOUNTS, 3)) {
+        state.bankAccounts.reserve(state.bankAccounts.size() + t->rows);
+        for (size_t r = 0; r < t->rows; r++) state.addAccount(t->cols[0].i32(r), t->cols[1].name(r, names), t->cols[2].money(r));
+    }
+    if (const Table *t = find_table(tables, T_BUYERS, 6)) {
+        state.buyers.reserve(state.buyers.size() + t->rows);
+        for (size_t r = 0; r < t->rows; r++) {
+            int id = t->cols[0].i32(r);
+            AccountHandle acc = t->cols[5].i32(r) ? state.accountHandle(id) : AccountHandle();
+            state.addBuyer(id, t->cols[1].name(r, names), t->cols[2].str(r), t->cols[3].str(r), t->cols[4].str(r), acc);
+        }
+    }
+    if (const Table *t = find_table(tables, T_SELLERS, 3)) {
+        state.sellers.reserve(state.sellers.size() + t->rows);
+        for (size_t r = 0; r < t->rows; r++) {
+            int buyerId = t->cols[0].i32(r);
+            if (state.findBuyer(buyerId)) state.addSeller(buyerId, t->cols[1].i32(r), t->cols[2].name(r, names));
+        }
+    }
+    if (const Table *t = find_table(tables, T_ITEMS, 5)) {
+        for (size_t r = 0; r < t->rows; r++) {
+            if (seller *s = state.findSeller(t->cols[0].i32(r))) {
+                state.addItem(*s, t->cols[1].i32(r), t->cols[2].name(r, names), t->cols[3].i32(r), t->cols[4].money(r));
+            }
+        }
+    }
+    auto load_orders = [&](TableId id, OrderList &orders) {
+        const Table *t = find_table(tables, id, 8);
+        if (!t) return;
+        orders.reserve(orders.size() + t->rows);
+        for (size_t r = 0; r < t->rows; r++) {
+            orders.push_back(&state.createOrder(t->cols[0].i32(r), t->cols[1].i32(r), t->cols[2].sym(r, names), t->cols[3].i32(r),
+                                                t->cols[4].sym(r, names), t->cols[5].money(r),
+                                                static_cast<TransactionStatus>(t->cols[6].i32(r)), t->cols[7].day(r)));
+        }
+    };
+    load_orders(T_TRANSACTIONS, state.transactions);
+    load_orders(T_PENDING_ORDERS, state.pendingOrders);
+    if (const Table *t = find_table(tables, T_TRANSACTION_ITEMS, 5)) {
+        std::unordered_map<int, Transaction *> orderById;
+        orderById.reserve(state.transactions.size() + state.pendingOrders.size());
+        for (auto &tx : state.transactions) orderById.emplace(tx.getTransactionId(), &tx);
+        for (auto &tx : state.pendingOrders) orderById.emplace(tx.getTransactionId(), &tx);
+        for (size_t r = 0; r < t->rows; r++) {
+            auto it = orderById.find(t->cols[0].i32(r));
+            if (it != orderById.end()) it->second->restoreItem(t->cols[1].i32(r), t->cols[2].sym(r, names), t->cols[3].i32(r), t->cols[4].money(r));
+        }
+    }
+    return true;
+}
+
+Format detect_format(const std::string &path) {
+    std::error_code ec;
+    return fs::exists(path + "/" + SNAPSHOT_FILE, ec) ? Format::BINARY : Format::TEXT;
+}
+
+}
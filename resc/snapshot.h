@@ -0,0 +1,29 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include <string>
+#include "app_state.h"
+
+using namespace std;
+
+// Binary columnar snapshot (snapshot.bin), the alternative to the *.txt tables.
+//
+//   header : "MKTSNAP\0" | u32 version | u32 tableCount
+//   table  : u32 tableId | u32 columnCount | u64 rows | u64 payloadBytes | u64 fnv1a(payload) | payload
+//   column : u32 type | u32 reserved | data, padded to 8 bytes
+//            I32/I64/F64 -> rows fixed-width values
+//            STR         -> (rows + 1) u32 offsets into a string heap, then the heap
+//
+// Values are stored in host (little-endian) byte order.
+namespace store {
+    enum class Format { TEXT, BINARY };
+
+    const char *const SNAPSHOT_FILE = "snapshot.bin";
+
+    bool save_binary(const AppState &state, const string &path);
+    bool load_binary(AppState &state, const string &path);
+    // BINARY when path holds a snapshot.bin, which then takes precedence over the text tables.
+    Format detect_format(const string &path);
+}
+
+#endif // SNAPSHOT_H
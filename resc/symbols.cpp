@@ -0,0 +1,101 @@
+#include "symbols.h"
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+#include <memory>
+#include <mutex>
+#include <shared_mutex>
+#include <stdexcept>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+using namespace std;
+
+namespace symbols {
+
+// Ids index a two-level table whose blocks are allocated once and never
+// moved, so readers need no lock: an id is only ever seen after the entry
+// it names was written.
+static constexpr size_t BLOCK = 4096;
+static constexpr size_t MAX_BLOCKS = 65536;   // room for 2^28 strings
+static constexpr size_t CHARS = 64 * 1024;    // bytes per text block
+
+namespace {
+struct Table {
+    atomic<string_view*> blocks[MAX_BLOCKS] = {};
+    atomic<size_t> size{1};
+
+    shared_mutex lock;
+    unordered_map<string_view, Id> ids;   // views into `text`
+    vector<unique_ptr<char[]>> text;
+    size_t textLeft = 0;
+    char* textAt = nullptr;
+
+    Table() {
+        blocks[0].store(new string_view[BLOCK](), memory_order_relaxed);
+        ids.emplace(string_view(), EMPTY);
+    }
+    ~Table() {
+        for (auto& b : blocks) delete[] b.load(memory_order_relaxed);
+    }
+
+    // Copies the bytes into stable storage; caller holds `lock` exclusively.
+    string_view store(string_view s) {
+        if (s.size() > textLeft) {
+            size_t n = max(CHARS, s.size());
+            text.push_back(make_unique<char[]>(n));
+            textAt = text.back().get();
+            textLeft = n;
+        }
+        memcpy(textAt, s.data(), s.size());
+        string_view kept(textAt, s.size());
+        textAt += s.size();
+        textLeft -= s.size();
+        return kept;
+    }
+};
+
+Table& table() {
+    static Table t;
+    return t;
+}
+}
+
+Id intern(string_view text) {
+    if (text.empty()) return EMPTY;
+    Table& t = table();
+    {
+        shared_lock<shared_mutex> read(t.lock);
+        auto it = t.ids.find(text);
+        if (it != t.ids.end()) return it->second;
+    }
+    unique_lock<shared_mutex> write(t.lock);
+    auto it = t.ids.find(text);
+    if (it != t.ids.end()) return it->second;
+
+    size_t n = t.size.load(memory_order_relaxed);
+    if (n >= BLOCK * MAX_BLOCKS) throw length_error("symbol table full");
+    string_view* block = t.blocks[n / BLOCK].load(memory_order_relaxed);
+    if (!block) {
+        block = new string_view[BLOCK]();
+        t.blocks[n / BLOCK].store(block, memory_order_release);
+    }
+    string_view kept = t.store(text);
+    block[n % BLOCK] = kept;
+    t.ids.emplace(kept, static_cast<Id>(n));
+    t.size.store(n + 1, memory_order_release);
+    return static_cast<Id>(n);
+}
+
+string_view view(Id id) {
+    Table& t = table();
+    if (id >= t.size.load(memory_order_acquire)) return string_view();
+    return t.blocks[id / BLOCK].load(memory_order_acquire)[id % BLOCK];
+}
+
+size_t count() {
+    return table().size.load(memory_order_acquire);
+}
+
+}
@@ -0,0 +1,27 @@
+#ifndef SYMBOLS_H
+#define SYMBOLS_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string_view>
+
+using namespace std;
+
+// Process-wide string interning for names (buyers, stores, items, accounts).
+// Each distinct string is stored once and never freed, and entities hold its
+// 32-bit id. view() is lock-free and its result stays valid for the life of
+// the program; intern() takes a lock only to add a string it has not seen.
+namespace symbols {
+
+using Id = uint32_t;
+// The empty string; a default-constructed Id.
+constexpr Id EMPTY = 0;
+
+Id intern(string_view text);
+string_view view(Id id);
+// Distinct strings interned so far, the empty one included.
+size_t count();
+
+}
+
+#endif // SYMBOLS_H
@@ -6,17 +6,28 @@
 using namespace std;
 
 
-int Transaction::nextTransactionId = 1;
+std::atomic<int> Transaction::nextTransactionId{1};
 
+void Transaction::seedNextId(int next) {
+    int cur = nextTransactionId.load(std::memory_order_relaxed);
+    while (cur < next && !nextTransactionId.compare_exchange_weak(cur, next, std::memory_order_relaxed)) {}
+}
 
-Transaction::Transaction(int bId, const string& bName, int sId, const string& sName, const std::string& date)
-    : buyerId(bId), buyerName(bName), sellerId(sId), sellerName(sName), 
-      totalAmount(0.0), status(PENDING), date(date) {
-    transactionId = nextTransactionId++;
-    if (this->date.empty()) {
-        // Default to today if not provided - automatically gets current date from system
-        this->date = dt::today();
-    }
+
+Transaction::Transaction(int bId, symbols::Id bName, int sId, symbols::Id sName, dt::Day date,
+                         std::pmr::memory_resource* lines)
+    : buyerId(bId), buyerName(bName), sellerId(sId), sellerName(sName), items(lines),
+      totalAmount(), status(PENDING), date(date == dt::NO_DAY ? dt::current_day() : date) {
+    transactionId = nextTransactionId.fetch_add(1, std::memory_order_relaxed);
+}
+
+Transaction::Transaction(int id, int bId, symbols::Id bName, int sId, symbols::Id sName,
+                         Money total, TransactionStatus status, dt::Day date,
+                         std::pmr::memory_resource* lines)
+    : transactionId(id), buyerId(bId), buyerName(bName), sellerId(sId), sellerName(sName), items(lines),
+      totalAmount(total), status(status), date(date) {
+    // New transactions must not reuse an id that is already on disk
+    seedNextId(id + 1);
 }
 
 
@@ -28,23 +39,23 @@ int Transaction::getBuyerId() const {
     return buyerId;
 }
 
-string Transaction::getBuyerName() const {
-    return buyerName;
+string_view Transaction::getBuyerName() const {
+    return symbols::view(buyerName);
 }
 
 int Transaction::getSellerId() const {
     return sellerId;
 }
 
-string Transaction::getSellerName() const {
-    return sellerName;
+string_view Transaction::getSellerName() const {
+    return symbols::view(sellerName);
 }
 
-const vector<TransactionItem>& Transaction::getItems() const {
+const std::pmr::vector<TransactionItem>& Transaction::getItems() const {
     return items;
 }
 
-double Transaction::getTotalAmount() const {
+Money Transaction::getTotalAmount() const {
     return totalAmount;
 }
 
@@ -68,13 +79,17 @@ void Transaction::setStatus(TransactionStatus newStatus) {
 }
 
 
-void Transaction::addItem(int itemId, const string& itemName, int quantity, double price) {
+void Transaction::addItem(int itemId, symbols::Id itemName, int quantity, Money price) {
     items.emplace_back(itemId, itemName, quantity, price);
     calculateTotal();
 }
 
+void Transaction::restoreItem(int itemId, symbols::Id itemName, int quantity, Money price) {
+    items.emplace_back(itemId, itemName, quantity, price);
+}
+
 void Transaction::calculateTotal() {
-    totalAmount = 0.0;
+    totalAmount = Money();
     for (const auto& item : items) {
         totalAmount += item.getTotalPrice();
     }
@@ -83,19 +98,19 @@ void Transaction::calculateTotal() {
 void Transaction::printTransactionDetails() const {
     cout << "\n=== Transaction #" << transactionId << " ===" << endl;
     cout << "Status: " << getStatusString() << endl;
-    cout << "Buyer: " << buyerName << " (ID: " << buyerId << ")" << endl;
-    cout << "Seller: " << sellerName << " (ID: " << sellerId << ")" << endl;
-        cout << "Date: " << date << endl;
+    cout << "Buyer: " << getBuyerName() << " (ID: " << buyerId << ")" << endl;
+    cout << "Seller: " << getSellerName() << " (ID: " << sellerId << ")" << endl;
+        cout << "Date: " << getDate() << endl;
         cout << "\nItems:" << endl;
     cout << "---------------------------------------" << endl;
     
     for (const auto& item : items) {
         cout << "  " << item.getItemName() 
              << " x" << item.getQuantity()
-             << " @ $" << fixed << setprecision(2) << item.getPricePerUnit()
-             << " = $" << fixed << setprecision(2) << item.getTotalPrice() << endl;
+             << " @ $" << item.getPricePerUnit()
+             << " = $" << item.getTotalPrice() << endl;
     }
     
     cout << "---------------------------------------" << endl;
-    cout << "Total Amount: $" << fixed << setprecision(2) << totalAmount << endl;
+    cout << "Total Amount: $" << totalAmount << endl;
 }
@@ -2,8 +2,15 @@
 #define TRANSACTION_H
 
 
+#include <atomic>
+#include <cstddef>
+#include <memory_resource>
 #include <string>
+#include <string_view>
 #include <vector>
+#include "money.h"
+#include "datetime.h"
+#include "symbols.h"
 using namespace std;
 
 enum TransactionStatus {
@@ -13,60 +20,124 @@ enum TransactionStatus {
     CANCELLED   
 };
 
+// Names are symbol ids (see symbols.h), so a line item is four words and
+// copying an order copies no strings.
 class TransactionItem {
 private:
     int itemId;
-    string itemName;
+    symbols::Id itemName;
     int quantity;
-    double pricePerUnit;
+    Money pricePerUnit;
 
 public:
-    TransactionItem(int id, const string& name, int qty, double price)
+    TransactionItem(int id, symbols::Id name, int qty, Money price)
         : itemId(id), itemName(name), quantity(qty), pricePerUnit(price) {}
 
     int getItemId() const { return itemId; }
-    string getItemName() const { return itemName; }
+    string_view getItemName() const { return symbols::view(itemName); }
+    symbols::Id getItemNameId() const { return itemName; }
     int getQuantity() const { return quantity; }
-    double getPricePerUnit() const { return pricePerUnit; }
-    double getTotalPrice() const { return quantity * pricePerUnit; }
+    Money getPricePerUnit() const { return pricePerUnit; }
+    Money getTotalPrice() const { return pricePerUnit * quantity; }
 };
 
 class Transaction {
 private:
-    static int nextTransactionId;
+    // Shared by every session; a single fetch_add hands out each id, no lock.
+    static std::atomic<int> nextTransactionId;
     int transactionId;
     int buyerId;
-    string buyerName;
+    symbols::Id buyerName;
     int sellerId;
-    string sellerName;
-    vector<TransactionItem> items;
-    double totalAmount;
+    symbols::Id sellerName;
+    // Allocated from the resource given at construction, normally the
+    // store's line-item pool; copies use the default heap.
+    std::pmr::vector<TransactionItem> items;
+    Money totalAmount;
     TransactionStatus status;
-    std::string date;
+    dt::Day date;
 
 public:
-    Transaction(int bId, const string& bName, int sId, const string& sName, const std::string& date = "");
+    // Dated today unless a date is given.
+    Transaction(int bId, symbols::Id bName, int sId, symbols::Id sName, dt::Day date = dt::NO_DAY,
+                std::pmr::memory_resource* lines = std::pmr::get_default_resource());
+    // Rebuilds a persisted transaction exactly: id, total and status are kept as stored.
+    Transaction(int id, int bId, symbols::Id bName, int sId, symbols::Id sName,
+                Money total, TransactionStatus status, dt::Day date,
+                std::pmr::memory_resource* lines = std::pmr::get_default_resource());
 
 
+    // Raises the next id to at least `next`; ids already handed out stay unique.
+    static void seedNextId(int next);
+
     int getTransactionId() const;
     int getBuyerId() const;
-    string getBuyerName() const;
+    string_view getBuyerName() const;
+    symbols::Id getBuyerNameId() const { return buyerName; }
     int getSellerId() const;
-    string getSellerName() const;
-    const vector<TransactionItem>& getItems() const;
-    double getTotalAmount() const;
+    string_view getSellerName() const;
+    symbols::Id getSellerNameId() const { return sellerName; }
+    const std::pmr::vector<TransactionItem>& getItems() const;
+    Money getTotalAmount() const;
     TransactionStatus getStatus() const;
     string getStatusString() const;
-    const std::string& getDate() const { return date; }
-    void setDate(const std::string& d) { date = d; }
+    dt::Day getDay() const { return date; }
+    // YYYY-MM-DD, or empty if the order has no valid date.
+    string getDate() const { return dt::format(date); }
+    void setDate(dt::Day d) { date = d; }
 
  
     void setStatus(TransactionStatus newStatus);
 
 
-    void addItem(int itemId, const string& itemName, int quantity, double price);
+    void addItem(int itemId, symbols::Id itemName, int quantity, Money price);
+    // Appends a persisted line item without recomputing the stored total.
+    void restoreItem(int itemId, symbols::Id itemName, int quantity, Money price);
+    void reserveItems(size_t n) { items.reserve(n); }
     void calculateTotal();
     void printTransactionDetails() const;
 };
 
+// A sequence of orders held by pointer; the orders themselves live in the
+// store's arena, so moving one between lists relinks it without a copy.
+// Iterating yields the orders, not the pointers.
+class OrderList {
+private:
+    vector<Transaction*> rows;
+
+    template <typename Ref, typename It>
+    class Iter {
+        It at;
+    public:
+        explicit Iter(It it) : at(it) {}
+        Ref operator*() const { return **at; }
+        Iter& operator++() { ++at; return *this; }
+        bool operator!=(const Iter& other) const { return at != other.at; }
+    };
+
+public:
+    using iterator = Iter<Transaction&, vector<Transaction*>::const_iterator>;
+    using const_iterator = Iter<const Transaction&, vector<Transaction*>::const_iterator>;
+
+    iterator begin() { return iterator(rows.cbegin()); }
+    iterator end() { return iterator(rows.cend()); }
+    const_iterator begin() const { return const_iterator(rows.cbegin()); }
+    const_iterator end() const { return const_iterator(rows.cend()); }
+
+    size_t size() const { return rows.size(); }
+    bool empty() const { return rows.empty(); }
+    void reserve(size_t n) { rows.reserve(n); }
+    Transaction& operator[](size_t i) { return *rows[i]; }
+    const Transaction& operator[](size_t i) const { return *rows[i]; }
+    Transaction& back() { return *rows.back(); }
+
+    void push_back(Transaction* order) { rows.push_back(order); }
+    // Unlinks entry i by moving the last entry into its place.
+    void swapRemove(size_t i) {
+        rows[i] = rows.back();
+        rows.pop_back();
+    }
+    void clear() { rows.clear(); }
+};
+
 #endif // TRANSACTION_H
@@ -0,0 +1,91 @@
+// Counts heap allocations made by market::topUp against databases of
+// different sizes; a top-up touches one buyer and one account, so the count
+// must not depend on how many others exist.
+//   alloc_check [buyers ...] [--calls n]
+//
+// Global operator new is replaced by a counting one. Every size tops up the
+// same low-numbered buyers by the same amounts, so the journal records are
+// byte for byte alike and only the size of the tables differs. Compaction
+// is switched off, as rewriting the snapshot is proportional by design.
+#include <algorithm>
+#include <atomic>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <new>
+#include <string>
+#include <unistd.h>
+#include <vector>
+#include "market.h"
+
+using namespace std;
+
+static atomic<size_t> allocations{0};
+
+void* operator new(size_t size) {
+    allocations.fetch_add(1, memory_order_relaxed);
+    if (void* p = malloc(size ? size : 1)) return p;
+    throw bad_alloc();
+}
+void operator delete(void* p) noexcept { free(p); }
+void operator delete(void* p, size_t) noexcept { free(p); }
+
+// Allocations per market::topUp over `calls` calls on buyers 1..100.
+static double allocationsPerTopUp(size_t buyers, int calls, const string& dir) {
+    filesystem::remove_all(dir);
+    AppState state;
+    store::Journal journal(dir, SIZE_MAX);
+    state.bankAccounts.reserve(buyers);
+    state.buyers.reserve(buyers);
+    for (size_t i = 1; i <= buyers; i++) {
+        int id = static_cast<int>(i);
+        state.addAccount(id, "Buyer", Money::fromCents(100000));
+        state.addBuyer(id, "Buyer", "buyer@example.com", "0812", "Street", state.accountHandle(id));
+    }
+    const int targets = static_cast<int>(min<size_t>(buyers, 100));
+    auto run = [&](int n) {
+        for (int i = 0; i < n; i++) market::topUp(state, journal, i % targets + 1, Money::fromCents(1));
+    };
+    // First calls size the journal's per-thread buffer
+    run(targets);
+    size_t before = allocations.load();
+    run(calls);
+    return static_cast<double>(allocations.load() - before) / calls;
+}
+
+int main(int argc, char* argv[]) {
+    vector<size_t> sizes;
+    int calls = 1000;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--calls" && i + 1 < argc) {
+            calls = atoi(argv[++i]);
+        } else {
+            sizes.push_back(strtoull(argv[i], nullptr, 10));
+        }
+    }
+    if (sizes.empty()) sizes = {1000, 100000, 1000000};
+    if (calls <= 0 || find(sizes.begin(), sizes.end(), 0) != sizes.end()) {
+        fprintf(stderr, "usage: %s [buyers ...] [--calls n]\n", argv[0]);
+        return 1;
+    }
+
+    string dir = (filesystem::temp_directory_path() / ("alloc_check." + to_string(getpid()))).string();
+    printf("--- Heap allocations per market::topUp, over %d calls ---\n", calls);
+    vector<double> counts;
+    for (size_t buyers : sizes) {
+        counts.push_back(allocationsPerTopUp(buyers, calls, dir));
+        printf("%10zu buyers : %.2f\n", buyers, counts.back());
+    }
+    filesystem::remove_all(dir);
+    // Building the tables allocates, so a zero total means new is not ours
+    if (allocations.load() == 0) {
+        printf("[X] operator new was not replaced; nothing was counted\n");
+        return 3;
+    }
+    if (*max_element(counts.begin(), counts.end()) != *min_element(counts.begin(), counts.end())) {
+        printf("[X] Allocations depend on the database size\n");
+        return 3;
+    }
+    return 0;
+}
@@ -0,0 +1,137 @@
+// Times catalog queries against the plain loop over per-item objects that
+// Browse Stores used before the catalog was columnar, then name searches.
+//   catalog_bench [rows] [sellers] [repeats]
+//
+// Runs "under $X with qty > 0" and "sellers with a sold-out item" both
+// ways on the same synthetic data and checks that the answers agree.
+// Search latency is the mean over word, prefix, two-word and misspelt queries.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <random>
+#include <string>
+#include <vector>
+#include "catalog.h"
+#include "catalog_query.h"
+#include "search_index.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// The row layout items had inside each seller before the catalog.
+struct ItemObject {
+    int id;
+    string name;
+    int quantity;
+    Money price;
+    bool display;
+};
+
+// Synthetic vocabulary: "ba", "be", ... two to four letters per syllable pair.
+static string word(size_t n) {
+    static const char *syllables[] = {"ba", "ke", "lo", "mi", "nu", "ra", "se", "ti", "vo", "zu", "pe", "do"};
+    string w;
+    do {
+        w += syllables[n % 12];
+        n /= 12;
+    } while (n);
+    return w;
+}
+
+template <typename Fn>
+static double bestOf(int repeats, Fn fn) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; i++) {
+        Clock::time_point start = Clock::now();
+        fn();
+        best = min(best, chrono::duration<double, milli>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    size_t rows = argc > 1 ? strtoull(argv[1], nullptr, 10) : 10000000;
+    int sellers = argc > 2 ? atoi(argv[2]) : 10000;
+    int repeats = argc > 3 ? atoi(argv[3]) : 5;
+    if (rows == 0 || sellers <= 0 || repeats <= 0) {
+        fprintf(stderr, "usage: %s [rows] [sellers] [repeats]\n", argv[0]);
+        return 1;
+    }
+
+    mt19937_64 rng(42);
+    uniform_int_distribution<int> qty(-20, 200);
+    uniform_int_distribution<int64_t> cents(1, 500000);
+    Catalog catalog;
+    vector<vector<ItemObject>> objects(static_cast<size_t>(sellers));
+    for (size_t r = 0; r < rows; r++) {
+        int sellerId = static_cast<int>(r * static_cast<size_t>(sellers) / rows) + 1;
+        int q = max(qty(rng), 0);
+        Money price = Money::fromCents(cents(rng));
+        string name = word(rng() % 20000) + " " + word(rng() % 2000);
+        catalog.insert(sellerId, static_cast<int>(r), name, q, price);
+        objects[static_cast<size_t>(sellerId - 1)].push_back({static_cast<int>(r), name, q, price, false});
+    }
+
+    query::ItemFilter cheap;
+    cheap.maxPrice = Money::fromCents(10000 - 1);
+    cheap.minQuantity = 1;
+    query::ItemFilter soldOut;
+    soldOut.maxQuantity = 0;
+
+    size_t naiveCheap = 0, queryCheap = 0, naiveSoldOut = 0, querySoldOut = 0;
+    double naiveCheapMs = bestOf(repeats, [&] {
+        vector<int> hits;
+        for (const auto &items : objects) {
+            for (const auto &item : items) {
+                if (item.price <= cheap.maxPrice && item.quantity >= 1) hits.push_back(item.id);
+            }
+        }
+        naiveCheap = hits.size();
+    });
+    double queryCheapMs = bestOf(repeats, [&] { queryCheap = query::select(catalog, cheap).size(); });
+    double naiveSoldOutMs = bestOf(repeats, [&] {
+        vector<int> hits;
+        for (size_t s = 0; s < objects.size(); s++) {
+            for (const auto &item : objects[s]) {
+                if (item.quantity <= 0) {
+                    hits.push_back(static_cast<int>(s) + 1);
+                    break;
+                }
+            }
+        }
+        naiveSoldOut = hits.size();
+    });
+    double querySoldOutMs = bestOf(repeats, [&] { querySoldOut = query::sellersWith(catalog, soldOut).size(); });
+
+    SearchIndex index;
+    Clock::time_point built = Clock::now();
+    for (size_t r = 0; r < rows; r++) index.add(catalog.sellerId(r), catalog.itemId(r), catalog.name(r));
+    double buildMs = chrono::duration<double, milli>(Clock::now() - built).count();
+    vector<string> queries;
+    for (size_t i = 0; i < 200; i++) {
+        string w = word(rng() % 20000);
+        switch (i % 4) {
+            case 0: queries.push_back(w); break;
+            case 1: queries.push_back(w.substr(0, 3)); break;
+            case 2: queries.push_back(w + " " + word(rng() % 2000)); break;
+            default: queries.push_back(w.substr(0, w.size() - 1) + "x"); break;
+        }
+    }
+    size_t searchHits = 0;
+    double searchMs = bestOf(repeats, [&] {
+        searchHits = 0;
+        for (const string &q : queries) searchHits += index.search(q).hits.size();
+    }) / static_cast<double>(queries.size());
+
+    printf("--- %zu rows over %d sellers, best of %d, kernel %s ---\n", rows, sellers, repeats, query::kernelName());
+    printf("Under $100, in stock : naive %8.2f ms  catalog %8.2f ms  (%zu rows)\n", naiveCheapMs, queryCheapMs, queryCheap);
+    printf("Sellers sold out     : naive %8.2f ms  catalog %8.2f ms  (%zu sellers)\n", naiveSoldOutMs, querySoldOutMs, querySoldOut);
+    printf("Name search          : %.3f ms per query, %zu hits over %zu queries (%zu words, built in %.0f ms)\n",
+           searchMs, searchHits, queries.size(), index.wordCount(), buildMs);
+    if (naiveCheap != queryCheap || naiveSoldOut != querySoldOut) {
+        printf("[X] Results differ: naive %zu/%zu, catalog %zu/%zu\n", naiveCheap, naiveSoldOut, queryCheap, querySoldOut);
+        return 3;
+    }
+    return 0;
+}
@@ -0,0 +1,49 @@
+// Migrates a database directory between the text tables and snapshot.bin.
+//   db_convert <data-dir> text|binary
+#include <filesystem>
+#include <iostream>
+#include <string>
+#include "persistence.h"
+#include "journal.h"
+
+using namespace std;
+
+int main(int argc, char** argv) {
+    if (argc != 3 || (string(argv[2]) != "text" && string(argv[2]) != "binary")) {
+        cerr << "Usage: " << argv[0] << " <data-dir> text|binary" << endl;
+        return 2;
+    }
+    string path = argv[1];
+    store::Format target = string(argv[2]) == "binary" ? store::Format::BINARY : store::Format::TEXT;
+
+    AppState state;
+    store::LoadResult loaded = store::load_all(state, path);
+    if (loaded == store::LoadResult::CORRUPT) {
+        cerr << "[X] " << path << "/" << store::SNAPSHOT_FILE << " is damaged; nothing converted" << endl;
+        return 1;
+    }
+    if (loaded == store::LoadResult::EMPTY) {
+        cerr << "[X] Nothing to convert in " << path << endl;
+        return 1;
+    }
+    // Every table has to exist in the target format
+    state.markDirty(TABLE_ALL);
+    // The new snapshot already contains every journaled mutation
+    store::Journal journal(path);
+    state.coveredJournals = journal.generation() + 1;
+    if (!store::save_all(state, path, target)) {
+        cerr << "[X] Failed to write " << argv[2] << " snapshot" << endl;
+        return 1;
+    }
+    journal.reset();
+    if (target == store::Format::TEXT) {
+        // Otherwise load_all would keep preferring the stale binary snapshot
+        error_code ec;
+        filesystem::remove(path + "/" + store::SNAPSHOT_FILE, ec);
+    }
+
+    cout << "Converted " << path << " to " << argv[2] << ": "
+         << state.buyers.size() << " buyers, " << state.sellers.size() << " sellers, "
+         << state.bankAccounts.size() << " accounts, " << state.transactions.size() << " transactions" << endl;
+    return 0;
+}
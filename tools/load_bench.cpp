@@ -0,0 +1,187 @@
+// Times store::load_all on generated text tables, reading them line by line
+// (LoadMode::STREAM) and through a memory map (LoadMode::MAPPED).
+//   load_bench [rows ...] [--repeats n] [--max-growth x]
+//
+// For each size, a database of that many rows in total is written to a
+// temporary directory: a tenth each buyers and accounts, a hundredth sellers,
+// a fifth items, a fifth paid orders plus a fiftieth pending ones, and the
+// rest order lines. Both modes must load the same counts.
+//
+// Loading has to stay linear: if the time per row at the largest size is
+// more than x (default 3) times that at the smallest, it fails, so a join
+// that scans a table per row cannot come back unnoticed.
+#include <algorithm>
+#include <charconv>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <unistd.h>
+#include <vector>
+#include "persistence.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// Buffers one table and writes it out in large blocks.
+class TableWriter {
+public:
+    explicit TableWriter(const string& file) : f(fopen(file.c_str(), "w")) {}
+    ~TableWriter() {
+        flush();
+        if (f) fclose(f);
+    }
+    // Appends the fields joined by '|' and a newline.
+    template <typename... Fields>
+    void row(const Fields&... fields) {
+        size_t n = 0;
+        ((put(fields), buf += ++n < sizeof...(fields) ? '|' : '\n'), ...);
+        if (buf.size() > (1 << 20)) flush();
+    }
+    bool ok() const { return f != nullptr; }
+
+private:
+    FILE* f;
+    string buf;
+    void put(string_view text) { buf += text; }
+    void put(const string& text) { buf += text; }
+    void put(const char* text) { buf += text; }
+    void put(Money amount) {
+        char out[Money::MAX_CHARS];
+        buf.append(out, amount.format(out));
+    }
+    template <typename T>
+    void put(T number) {
+        char out[24];
+        buf.append(out, static_cast<size_t>(to_chars(out, out + sizeof out, number).ptr - out));
+    }
+    void flush() {
+        if (f) fwrite(buf.data(), 1, buf.size(), f);
+        buf.clear();
+    }
+};
+
+struct Counts {
+    size_t buyers, sellers, accounts, items, transactions, pending, lines;
+    bool operator==(const Counts&) const = default;
+};
+
+static bool generate(const string& dir, size_t rows) {
+    size_t buyers = max<size_t>(rows / 10, 1);
+    size_t sellers = max<size_t>(rows / 100, 1);
+    size_t items = max<size_t>(rows / 5, 1);
+    size_t paid = max<size_t>(rows / 5, 1);
+    size_t pending = max<size_t>(rows / 50, 1);
+    size_t used = 2 * buyers + sellers + items + paid + pending;
+    size_t lines = rows > used ? rows - used : paid + pending;
+    size_t perSeller = max<size_t>(items / sellers, 1);
+    dt::Day today = dt::current_day();
+    char day[16];
+    auto name = [](const char* prefix, size_t n) { return prefix + to_string(n); };
+
+    TableWriter acc(dir + "/accounts.txt"), buy(dir + "/buyers.txt"), sel(dir + "/sellers.txt"), itm(dir + "/items.txt");
+    TableWriter txn(dir + "/transactions.txt"), pend(dir + "/pending_orders.txt"), txi(dir + "/transaction_items.txt");
+    if (!acc.ok() || !buy.ok() || !sel.ok() || !itm.ok() || !txn.ok() || !pend.ok() || !txi.ok()) return false;
+    for (size_t b = 1; b <= buyers; b++) {
+        acc.row(b, name("Buyer ", b), Money::fromCents(static_cast<int64_t>(b % 10000000)));
+        buy.row(b, name("Buyer ", b), name("buyer", b) + "@example.com", name("0812", b), name("Street ", b % 1000), 1);
+    }
+    for (size_t s = 1; s <= sellers; s++) sel.row(s, s, name("Store ", s));
+    for (size_t i = 0; i < items; i++) {
+        size_t s = min(i / perSeller, sellers - 1) + 1;
+        itm.row(s, i + 1, name("Item ", i % 5000), 1000000, Money::fromCents(static_cast<int64_t>(100 + i % 50000)));
+    }
+    const Money linePrice = Money::fromCents(200);
+    for (size_t t = 1; t <= paid + pending; t++) {
+        size_t b = t % buyers + 1, s = t % sellers + 1;
+        size_t nLines = lines / (paid + pending) + (t <= lines % (paid + pending) ? 1 : 0);
+        string_view date(day, dt::format(today - static_cast<int>(t % 365), day));
+        TableWriter& to = t <= paid ? txn : pend;
+        to.row(t, b, name("Buyer ", b), s, name("Store ", s), linePrice * static_cast<int64_t>(nLines),
+               static_cast<int>(t <= paid ? PAID : PENDING), date);
+        for (size_t l = 0; l < nLines; l++) {
+            size_t item = (s - 1) * perSeller + l % perSeller + 1;
+            txi.row(t, item, name("Item ", (item - 1) % 5000), 1, linePrice);
+        }
+    }
+    return true;
+}
+
+static double timeLoad(const string& dir, store::LoadMode mode, int repeats, Counts& counts) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; i++) {
+        AppState state;
+        Clock::time_point start = Clock::now();
+        store::load_all(state, dir, mode);
+        best = min(best, chrono::duration<double, milli>(Clock::now() - start).count());
+        counts = {state.buyers.size(), state.sellers.size(), state.bankAccounts.size(), state.catalog.size(),
+                  state.transactions.size(), state.pendingOrders.size(), 0};
+        for (const auto* orders : {&state.transactions, &state.pendingOrders}) {
+            for (const auto& t : *orders) counts.lines += t.getItems().size();
+        }
+    }
+    return best;
+}
+
+int main(int argc, char* argv[]) {
+    vector<size_t> sizes;
+    int repeats = 3;
+    double maxGrowth = 3;
+    for (int i = 1; i < argc; i++) {
+        string arg = argv[i];
+        if (arg == "--repeats" && i + 1 < argc) {
+            repeats = atoi(argv[++i]);
+        } else if (arg == "--max-growth" && i + 1 < argc) {
+            maxGrowth = atof(argv[++i]);
+        } else {
+            sizes.push_back(strtoull(argv[i], nullptr, 10));
+        }
+    }
+    if (sizes.empty()) sizes = {100000, 1000000, 10000000};
+    sort(sizes.begin(), sizes.end());
+    if (repeats <= 0 || maxGrowth <= 0 || sizes[0] == 0) {
+        fprintf(stderr, "usage: %s [rows ...] [--repeats n] [--max-growth x]\n", argv[0]);
+        return 1;
+    }
+
+    string dir = (filesystem::temp_directory_path() / ("load_bench." + to_string(getpid()))).string();
+    int status = 0;
+    printf("--- load_all on generated text tables, best of %d ---\n", repeats);
+    printf("%12s %12s %12s %14s %14s %10s\n", "rows", "stream ms", "mapped ms", "stream ns/row", "mapped ns/row", "speedup");
+    // Time per row at the smallest size, for the linearity check
+    double streamBase = 0, mappedBase = 0;
+    for (size_t rows : sizes) {
+        filesystem::remove_all(dir);
+        filesystem::create_directories(dir);
+        if (!generate(dir, rows)) {
+            fprintf(stderr, "[X] Cannot write tables in %s\n", dir.c_str());
+            status = 1;
+            break;
+        }
+        Counts streamed, mapped;
+        double streamMs = timeLoad(dir, store::LoadMode::STREAM, repeats, streamed);
+        double mappedMs = timeLoad(dir, store::LoadMode::MAPPED, repeats, mapped);
+        double streamNs = streamMs * 1e6 / static_cast<double>(rows);
+        double mappedNs = mappedMs * 1e6 / static_cast<double>(rows);
+        printf("%12zu %12.1f %12.1f %14.0f %14.0f %9.2fx\n", rows, streamMs, mappedMs, streamNs, mappedNs, streamMs / mappedMs);
+        if (streamBase == 0) {
+            streamBase = streamNs;
+            mappedBase = mappedNs;
+        } else if (streamNs > streamBase * maxGrowth || mappedNs > mappedBase * maxGrowth) {
+            printf("[X] Time per row grew %.1fx (stream) / %.1fx (mapped) since %zu rows; loading is no longer linear\n",
+                   streamNs / streamBase, mappedNs / mappedBase, sizes[0]);
+            status = 4;
+        }
+        size_t loaded = mapped.buyers + mapped.sellers + mapped.accounts + mapped.items + mapped.transactions
+                        + mapped.pending + mapped.lines;
+        if (!(streamed == mapped) || loaded != rows) {
+            printf("[X] %zu rows written, %zu loaded; stream/mapped: %zu/%zu buyers, %zu/%zu items, %zu/%zu order lines\n",
+                   rows, loaded, streamed.buyers, mapped.buyers, streamed.items, mapped.items, streamed.lines, mapped.lines);
+            status = 3;
+        }
+    }
+    filesystem::remove_all(dir);
+    return status;
+}
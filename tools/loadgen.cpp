@@ -0,0 +1,250 @@
+// Scripted load generator for market_server.
+//   loadgen <script> [connections] [iterations] [--unix path | --tcp port]
+//
+// The script holds one protocol request per line. Lines before a "%loop"
+// line run once per connection, the rest run `iterations` times. In each
+// request $c is replaced by the connection index and $r by the first field
+// of the first data line of that connection's previous response, so e.g.
+//   ORDER|1|1:1
+//   PAY|$r
+// pays for the order it just placed. Blank lines and '#' comments are skipped.
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <string>
+#include <vector>
+#include <arpa/inet.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+struct Client {
+    int fd = -1;
+    int index = 0;
+    size_t step = 0;          // next script line
+    size_t iteration = 0;
+    string in;
+    string out;
+    size_t sent = 0;
+    string lastResult;        // $r
+    Clock::time_point issued;
+    bool done = false;
+};
+
+static int connectTo(const string &unixPath, int tcpPort) {
+    int fd;
+    int rc;
+    if (tcpPort) {
+        fd = socket(AF_INET, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        int one = 1;
+        setsockopt(fd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+        sockaddr_in addr{};
+        addr.sin_family = AF_INET;
+        addr.sin_port = htons(static_cast<uint16_t>(tcpPort));
+        addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+        rc = connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof addr);
+    } else {
+        sockaddr_un addr{};
+        if (unixPath.size() >= sizeof addr.sun_path) return -1;
+        fd = socket(AF_UNIX, SOCK_STREAM, 0);
+        if (fd < 0) return -1;
+        addr.sun_family = AF_UNIX;
+        memcpy(addr.sun_path, unixPath.c_str(), unixPath.size() + 1);
+        rc = connect(fd, reinterpret_cast<sockaddr *>(&addr), sizeof addr);
+    }
+    if (rc != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static string expand(const string &line, const Client &c) {
+    string out;
+    for (size_t i = 0; i < line.size(); ++i) {
+        if (line[i] == '$' && i + 1 < line.size() && (line[i + 1] == 'c' || line[i + 1] == 'r')) {
+            out += line[i + 1] == 'c' ? to_string(c.index) : c.lastResult;
+            ++i;
+        } else {
+            out += line[i];
+        }
+    }
+    return out;
+}
+
+// Length of the first complete response in `buf`, or 0 if it is still partial.
+static size_t responseLength(const string &buf) {
+    size_t eol = buf.find('\n');
+    if (eol == string::npos) return 0;
+    if (buf.compare(0, 3, "OK|") != 0) return eol + 1;
+    size_t rows = strtoul(buf.c_str() + 3, nullptr, 10);
+    size_t at = eol + 1;
+    for (size_t i = 0; i < rows; ++i) {
+        size_t next = buf.find('\n', at);
+        if (next == string::npos) return 0;
+        at = next + 1;
+    }
+    return at;
+}
+
+int main(int argc, char **argv) {
+    vector<string> positional;
+    string unixPath = "/tmp/marketplace.sock";
+    int tcpPort = 0;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--unix" && i + 1 < argc) unixPath = argv[++i];
+        else if (arg == "--tcp" && i + 1 < argc) tcpPort = atoi(argv[++i]);
+        else positional.push_back(arg);
+    }
+    if (positional.empty() || positional.size() > 3) {
+        cerr << "Usage: " << argv[0] << " <script> [connections] [iterations] [--unix path | --tcp port]" << endl;
+        return 2;
+    }
+    int connections = positional.size() > 1 ? max(1, atoi(positional[1].c_str())) : 1;
+    size_t iterations = positional.size() > 2 ? static_cast<size_t>(max(0, atoi(positional[2].c_str()))) : 1;
+
+    ifstream scriptFile(positional[0]);
+    if (!scriptFile) {
+        cerr << "[X] Cannot read script " << positional[0] << endl;
+        return 1;
+    }
+    vector<string> script;
+    size_t loopStart = string::npos;
+    for (string line; getline(scriptFile, line);) {
+        if (!line.empty() && line.back() == '\r') line.pop_back();
+        if (line.empty() || line[0] == '#') continue;
+        if (line == "%loop") {
+            loopStart = script.size();
+            continue;
+        }
+        script.push_back(line);
+    }
+    if (loopStart == string::npos) loopStart = 0;
+    if (loopStart == script.size()) iterations = 0;
+    if (script.empty()) {
+        cerr << "[X] Script is empty" << endl;
+        return 1;
+    }
+
+    int epfd = epoll_create1(0);
+    vector<Client> clients(static_cast<size_t>(connections));
+    for (int i = 0; i < connections; ++i) {
+        Client &c = clients[static_cast<size_t>(i)];
+        c.index = i;
+        c.fd = connectTo(unixPath, tcpPort);
+        if (c.fd < 0) {
+            cerr << "[X] Connection " << i << " failed: " << strerror(errno) << endl;
+            return 1;
+        }
+        epoll_event ev{};
+        ev.events = EPOLLIN;
+        ev.data.u32 = static_cast<uint32_t>(i);
+        epoll_ctl(epfd, EPOLL_CTL_ADD, c.fd, &ev);
+    }
+
+    size_t requests = 0, errors = 0;
+    vector<double> latencies;
+    int active = connections;
+
+    // Sends the client's next request, or marks it done after its last iteration.
+    auto issue = [&](Client &c) {
+        if (c.step == script.size()) {
+            c.step = loopStart;
+            ++c.iteration;
+        }
+        if (c.iteration >= iterations && c.step >= loopStart) {
+            c.done = true;
+            --active;
+            shutdown(c.fd, SHUT_WR);
+            return;
+        }
+        c.out = expand(script[c.step++], c) + "\n";
+        c.sent = 0;
+        c.issued = Clock::now();
+        while (c.sent < c.out.size()) {
+            ssize_t n = send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+            if (n <= 0) {
+                if (n < 0 && errno == EINTR) continue;
+                cerr << "[X] Connection " << c.index << " lost" << endl;
+                c.done = true;
+                --active;
+                return;
+            }
+            c.sent += static_cast<size_t>(n);
+        }
+    };
+
+    Clock::time_point start = Clock::now();
+    for (auto &c : clients) issue(c);
+
+    epoll_event events[256];
+    char buf[16384];
+    while (active > 0) {
+        int n = epoll_wait(epfd, events, 256, 5000);
+        if (n == 0) {
+            cerr << "[X] Server stopped answering" << endl;
+            break;
+        }
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            Client &c = clients[events[i].data.u32];
+            if (c.done) {
+                epoll_ctl(epfd, EPOLL_CTL_DEL, c.fd, nullptr);
+                continue;
+            }
+            ssize_t got = recv(c.fd, buf, sizeof buf, 0);
+            if (got <= 0) {
+                if (got < 0 && errno == EINTR) continue;
+                cerr << "[X] Connection " << c.index << " closed by server" << endl;
+                c.done = true;
+                --active;
+                continue;
+            }
+            c.in.append(buf, static_cast<size_t>(got));
+            size_t len;
+            while ((len = responseLength(c.in)) != 0) {
+                latencies.push_back(chrono::duration<double, micro>(Clock::now() - c.issued).count());
+                ++requests;
+                if (c.in.compare(0, 3, "OK|") != 0) {
+                    ++errors;
+                    c.lastResult.clear();
+                } else {
+                    size_t row = c.in.find('\n') + 1;
+                    size_t end = row < len ? c.in.find_first_of("|\n", row) : row;
+                    c.lastResult = c.in.substr(row, end - row);
+                }
+                c.in.erase(0, len);
+                issue(c);
+            }
+        }
+    }
+    double seconds = chrono::duration<double>(Clock::now() - start).count();
+
+    for (auto &c : clients) close(c.fd);
+    close(epfd);
+
+    sort(latencies.begin(), latencies.end());
+    auto percentile = [&](double p) {
+        return latencies.empty() ? 0.0 : latencies[static_cast<size_t>(p * static_cast<double>(latencies.size() - 1))];
+    };
+    printf("--- %zu requests over %d connections in %.3f s ---\n", requests, connections, seconds);
+    printf("Throughput : %.0f requests/sec\n", seconds > 0 ? static_cast<double>(requests) / seconds : 0.0);
+    printf("Errors     : %zu\n", errors);
+    printf("Latency us : p50 %.1f  p99 %.1f  max %.1f\n", percentile(0.50), percentile(0.99), percentile(1.0));
+    return errors == 0 ? 0 : 3;
+}
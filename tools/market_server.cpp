@@ -0,0 +1,268 @@
+// Serves the marketplace to many concurrent sessions over one shared AppState.
+//   market_server [data-dir] [--unix path | --tcp port] [--threads n]
+// Speaks the line protocol from protocol.h; defaults to database/ and
+// /tmp/marketplace.sock. TCP listens on 127.0.0.1 only. Each of the n
+// threads runs its own epoll loop over the connections it accepted.
+#include <algorithm>
+#include <cerrno>
+#include <csignal>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <thread>
+#include <unordered_map>
+#include <vector>
+#include <arpa/inet.h>
+#include <fcntl.h>
+#include <netinet/in.h>
+#include <netinet/tcp.h>
+#include <sys/epoll.h>
+#include <sys/eventfd.h>
+#include <sys/socket.h>
+#include <sys/un.h>
+#include <unistd.h>
+#include "persistence.h"
+#include "journal.h"
+#include "market.h"
+#include "protocol.h"
+
+using namespace std;
+
+struct Connection {
+    int fd;
+    string in;
+    string out;
+    size_t sent = 0;
+    bool writing = false;
+    protocol::Session session;
+};
+
+static bool setNonBlocking(int fd) {
+    int flags = fcntl(fd, F_GETFL, 0);
+    return flags >= 0 && fcntl(fd, F_SETFL, flags | O_NONBLOCK) == 0;
+}
+
+static int listenUnix(const string &path) {
+    sockaddr_un addr{};
+    if (path.size() >= sizeof addr.sun_path) return -1;
+    int fd = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    addr.sun_family = AF_UNIX;
+    memcpy(addr.sun_path, path.c_str(), path.size() + 1);
+    unlink(path.c_str());
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof addr) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+static int listenTcp(int port) {
+    int fd = socket(AF_INET, SOCK_STREAM, 0);
+    if (fd < 0) return -1;
+    int one = 1;
+    setsockopt(fd, SOL_SOCKET, SO_REUSEADDR, &one, sizeof one);
+    sockaddr_in addr{};
+    addr.sin_family = AF_INET;
+    addr.sin_port = htons(static_cast<uint16_t>(port));
+    addr.sin_addr.s_addr = htonl(INADDR_LOOPBACK);
+    if (bind(fd, reinterpret_cast<sockaddr *>(&addr), sizeof addr) != 0 || listen(fd, SOMAXCONN) != 0) {
+        close(fd);
+        return -1;
+    }
+    return fd;
+}
+
+// Writes as much pending output as the socket takes; false once the peer is gone.
+static bool flushOut(int epfd, Connection &c) {
+    while (c.sent < c.out.size()) {
+        ssize_t n = send(c.fd, c.out.data() + c.sent, c.out.size() - c.sent, MSG_NOSIGNAL);
+        if (n > 0) {
+            c.sent += static_cast<size_t>(n);
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            return false;
+        }
+    }
+    if (c.sent == c.out.size()) {
+        c.out.clear();
+        c.sent = 0;
+    }
+    // Only watch for writability while a response is stuck in the buffer
+    bool want = !c.out.empty();
+    if (want != c.writing) {
+        epoll_event ev{};
+        ev.events = EPOLLIN | (want ? EPOLLOUT : 0u);
+        ev.data.fd = c.fd;
+        epoll_ctl(epfd, EPOLL_CTL_MOD, c.fd, &ev);
+        c.writing = want;
+    }
+    return true;
+}
+
+// Reads everything available and answers each complete request line.
+static bool serve(int epfd, Connection &c, AppState &state, store::Journal &journal) {
+    char buf[16384];
+    bool eof = false;
+    while (!eof) {
+        ssize_t n = recv(c.fd, buf, sizeof buf, 0);
+        if (n > 0) {
+            c.in.append(buf, static_cast<size_t>(n));
+        } else if (n < 0 && errno == EINTR) {
+            continue;
+        } else if (n < 0 && (errno == EAGAIN || errno == EWOULDBLOCK)) {
+            break;
+        } else {
+            eof = true;
+        }
+    }
+
+    size_t start = 0, end;
+    while (!c.session.closed && (end = c.in.find('\n', start)) != string::npos) {
+        protocol::handle(state, journal, c.session, string_view(c.in).substr(start, end - start), c.out);
+        start = end + 1;
+    }
+    c.in.erase(0, start);
+    return flushOut(epfd, c) && !eof && !(c.session.closed && c.out.empty());
+}
+
+// One event loop; the listening socket is shared by all loops and each
+// accepted connection stays with the loop that accepted it.
+static void runLoop(int lfd, int stopfd, bool tcp, AppState &state, store::Journal &journal) {
+    int epfd = epoll_create1(0);
+    epoll_event lev{};
+    lev.events = EPOLLIN | EPOLLEXCLUSIVE;  // wake one loop per new connection
+    lev.data.fd = lfd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, lfd, &lev);
+    epoll_event sev{};
+    sev.events = EPOLLIN;
+    sev.data.fd = stopfd;
+    epoll_ctl(epfd, EPOLL_CTL_ADD, stopfd, &sev);
+
+    unordered_map<int, Connection> conns;
+    epoll_event events[256];
+    bool stopping = false;
+    while (!stopping) {
+        int n = epoll_wait(epfd, events, 256, -1);
+        if (n < 0) {
+            if (errno == EINTR) continue;
+            break;
+        }
+        for (int i = 0; i < n; ++i) {
+            int fd = events[i].data.fd;
+            if (fd == stopfd) {
+                stopping = true;
+                continue;
+            }
+            if (fd == lfd) {
+                int cfd;
+                while ((cfd = accept4(lfd, nullptr, nullptr, SOCK_NONBLOCK | SOCK_CLOEXEC)) >= 0) {
+                    if (tcp) {
+                        int one = 1;
+                        setsockopt(cfd, IPPROTO_TCP, TCP_NODELAY, &one, sizeof one);
+                    }
+                    epoll_event ev{};
+                    ev.events = EPOLLIN;
+                    ev.data.fd = cfd;
+                    epoll_ctl(epfd, EPOLL_CTL_ADD, cfd, &ev);
+                    conns.emplace(cfd, Connection{cfd, {}, {}, 0, false, {}});
+                }
+                continue;
+            }
+
+            auto it = conns.find(fd);
+            if (it == conns.end()) continue;
+            Connection &c = it->second;
+            bool alive = !(events[i].events & EPOLLERR);
+            if (alive && (events[i].events & EPOLLOUT)) alive = flushOut(epfd, c) && !(c.session.closed && c.out.empty());
+            // A hang-up still gets its buffered requests answered; recv() then reports EOF
+            if (alive && (events[i].events & (EPOLLIN | EPOLLHUP))) alive = serve(epfd, c, state, journal);
+            if (!alive) {
+                epoll_ctl(epfd, EPOLL_CTL_DEL, fd, nullptr);
+                close(fd);
+                conns.erase(it);
+            }
+        }
+    }
+
+    for (auto &entry : conns) close(entry.first);
+    close(epfd);
+}
+
+int main(int argc, char **argv) {
+    string path = "database";
+    string unixPath = "/tmp/marketplace.sock";
+    int tcpPort = 0;
+    int threads = 1;
+    for (int i = 1; i < argc; ++i) {
+        string arg = argv[i];
+        if (arg == "--unix" && i + 1 < argc) {
+            unixPath = argv[++i];
+        } else if (arg == "--tcp" && i + 1 < argc) {
+            tcpPort = atoi(argv[++i]);
+        } else if (arg == "--threads" && i + 1 < argc) {
+            threads = max(1, atoi(argv[++i]));
+        } else if (arg[0] != '-') {
+            path = arg;
+        } else {
+            cerr << "Usage: " << argv[0] << " [data-dir] [--unix path | --tcp port] [--threads n]" << endl;
+            return 2;
+        }
+    }
+
+    // Block the stop signals before any thread starts, the journal worker
+    // included, so every thread inherits the mask. Only this thread waits for
+    // them, then wakes every loop through the eventfd.
+    sigset_t stopSignals;
+    sigemptyset(&stopSignals);
+    sigaddset(&stopSignals, SIGINT);
+    sigaddset(&stopSignals, SIGTERM);
+    pthread_sigmask(SIG_BLOCK, &stopSignals, nullptr);
+
+    AppState state;
+    store::ensure_data_dir(path);
+    if (store::load_all(state, path) == store::LoadResult::CORRUPT) {
+        cerr << "[X] " << path << "/" << store::SNAPSHOT_FILE << " is damaged; refusing to start" << endl;
+        return 1;
+    }
+    store::Journal journal(path);
+    journal.startBackground(chrono::milliseconds(5), store::Durability::FSYNC);
+
+    int lfd = tcpPort ? listenTcp(tcpPort) : listenUnix(unixPath);
+    if (lfd < 0 || !setNonBlocking(lfd)) {
+        cerr << "[X] Cannot listen on " << (tcpPort ? "127.0.0.1:" + to_string(tcpPort) : unixPath)
+             << ": " << strerror(errno) << endl;
+        return 1;
+    }
+
+    int stopfd = eventfd(0, EFD_CLOEXEC);
+
+    cout << "--- Serving " << path << " on " << (tcpPort ? "127.0.0.1:" + to_string(tcpPort) : unixPath)
+         << " with " << threads << " thread(s) (" << state.buyers.size() << " buyers, "
+         << state.sellers.size() << " sellers) ---" << endl;
+
+    vector<thread> loops;
+    for (int i = 0; i < threads; ++i) {
+        loops.emplace_back(runLoop, lfd, stopfd, tcpPort != 0, ref(state), ref(journal));
+    }
+    // Until a stop signal arrives, release stock held by stale unpaid orders
+    timespec sweepEvery{3600, 0};
+    do {
+        market::expireOrders(state, journal, market::ORDER_HOLD_DAYS);
+    } while (sigtimedwait(&stopSignals, nullptr, &sweepEvery) < 0);
+    uint64_t one = 1;
+    if (write(stopfd, &one, sizeof one) != sizeof one) cerr << "[X] Cannot stop event loops" << endl;
+    for (auto &t : loops) t.join();
+
+    close(stopfd);
+    close(lfd);
+    if (!tcpPort) unlink(unixPath.c_str());
+
+    // Make sure everything the sessions committed reached the disk
+    journal.flush();
+    cout << "\n--- Server stopped ---" << endl;
+    return 0;
+}
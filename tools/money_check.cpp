@@ -0,0 +1,149 @@
+// Checks Money parsing, formatting and arithmetic at the edges of its range.
+//   money_check
+//
+// Parsing must accept exactly the amounts that fit in int64 cents, from
+// -92233720368547758.08 to 92233720368547758.07, and refuse the rest rather
+// than overflow. Every amount must format and parse back to itself. Checked
+// operators must throw past either end, while MoneySum and Money::sum only
+// fail when the final total does not fit.
+#include <cstdio>
+#include <limits>
+#include <random>
+#include <stdexcept>
+#include <string>
+#include <vector>
+#include "catalog.h"
+#include "money.h"
+
+using namespace std;
+
+static const int64_t MAX_CENTS = numeric_limits<int64_t>::max();
+static const int64_t MIN_CENTS = numeric_limits<int64_t>::min();
+
+static int failures = 0;
+
+static void check(bool ok, const string& what) {
+    if (ok) return;
+    printf("[X] %s\n", what.c_str());
+    failures++;
+}
+
+template <typename Fn>
+static bool throwsOverflow(Fn fn) {
+    try {
+        fn();
+    } catch (const overflow_error&) {
+        return true;
+    }
+    return false;
+}
+
+// The sum if every step is checked, or false where a step overflows.
+static bool checkedSum(const vector<int64_t>& cents, Money& out) {
+    try {
+        Money total;
+        for (int64_t c : cents) total += Money::fromCents(c);
+        out = total;
+        return true;
+    } catch (const overflow_error&) {
+        return false;
+    }
+}
+
+int main() {
+    struct Case {
+        const char* text;
+        bool ok;
+        int64_t cents;
+    };
+    const Case cases[] = {
+        {"0", true, 0},
+        {"12", true, 1200},
+        {"12.5", true, 1250},
+        {"-12.34", true, -1234},
+        {"+3.07", true, 307},
+        {"92233720368547758.07", true, MAX_CENTS},
+        {"92233720368547758.08", false, 0},
+        {"92233720368547758.99", false, 0},
+        {"92233720368547759", false, 0},
+        {"-92233720368547758.08", true, MIN_CENTS},
+        {"-92233720368547758.09", false, 0},
+        {"-92233720368547758.99", false, 0},
+        {"99999999999999999999", false, 0},
+        {"6.76768e+09", true, 676768000000},
+        {"0.125", true, 13},
+        {"", false, 0},
+        {"-", false, 0},
+        {"--1", false, 0},
+        {"1.2.3", false, 0},
+        {"abc", false, 0},
+    };
+    for (const Case& c : cases) {
+        Money m = Money::fromCents(-1);
+        bool ok = Money::parse(c.text, m);
+        check(ok == c.ok && (!ok || m.cents() == c.cents),
+              string("parse \"") + c.text + "\": " + (ok ? m.toString() : "refused"));
+    }
+
+    for (int64_t cents : {MIN_CENTS, MIN_CENTS + 1, int64_t(-100), int64_t(-1), int64_t(0), int64_t(1), int64_t(99), MAX_CENTS}) {
+        Money m = Money::fromCents(cents), back;
+        check(Money::parse(m.toString(), back) && back == m, "format and parse " + to_string(cents) + " gives " + back.toString());
+    }
+
+    const Money max = Money::fromCents(MAX_CENTS), min = Money::fromCents(MIN_CENTS), one = Money::fromCents(1);
+    check(throwsOverflow([&] { (void)(max + one); }), "max + 0.01 did not throw");
+    check(throwsOverflow([&] { (void)(min - one); }), "min - 0.01 did not throw");
+    check(throwsOverflow([&] { (void)(max * 2); }), "max * 2 did not throw");
+    check(throwsOverflow([&] { (void)(min * -1); }), "min * -1 did not throw");
+    check(!throwsOverflow([&] { (void)(min + max); }), "min + max threw");
+
+    // Only the total is checked, so sums that pass out of range and back fit
+    const vector<vector<int64_t>> sums = {
+        {MAX_CENTS, 1, -1},
+        {MIN_CENTS, MIN_CENTS, MAX_CENTS, MAX_CENTS, 2},
+        {MIN_CENTS},
+        {MAX_CENTS, MAX_CENTS, MIN_CENTS, MIN_CENTS, -1, 1},
+    };
+    for (const auto& cents : sums) {
+        int64_t want = 0;
+        for (int64_t c : cents) want = static_cast<int64_t>(static_cast<uint64_t>(want) + static_cast<uint64_t>(c));
+        MoneySum acc;
+        for (int64_t c : cents) acc += Money::fromCents(c);
+        check(!throwsOverflow([&] { check(acc.total().cents() == want, "MoneySum total " + acc.total().toString()); }),
+              "MoneySum threw on a total that fits");
+        check(!throwsOverflow([&] { check(Money::sum(cents.data(), cents.size()).cents() == want, "Money::sum total"); }),
+              "Money::sum threw on a total that fits");
+    }
+    const vector<int64_t> over = {MAX_CENTS, MAX_CENTS}, under = {MIN_CENTS, -1};
+    for (const auto* cents : {&over, &under}) {
+        MoneySum acc;
+        for (int64_t c : *cents) acc += Money::fromCents(c);
+        check(throwsOverflow([&] { (void)acc.total(); }), "MoneySum did not throw on a total out of range");
+        check(throwsOverflow([&] { (void)Money::sum(cents->data(), cents->size()); }), "Money::sum did not throw on a total out of range");
+    }
+    mt19937_64 rng(3);
+    for (int i = 0; i < 1000; i++) {
+        vector<int64_t> cents(rng() % 100);
+        for (auto& c : cents) c = static_cast<int64_t>(rng() % (uint64_t(1) << 41)) - (int64_t(1) << 40);
+        Money want;
+        checkedSum(cents, want);
+        MoneySum acc;
+        for (int64_t c : cents) acc += Money::fromCents(c);
+        check(acc.total() == want && Money::sum(cents.data(), cents.size()) == want, "random sum " + to_string(i));
+    }
+
+    // Stock value: exact on the fast path, checked past its bound
+    Catalog catalog;
+    catalog.insert(1, 1, "a", 200, Money::fromCents(35000));
+    catalog.insert(1, 2, "b", 49, Money::fromCents(250000));
+    check(catalog.stockValue(catalog.rangeOf(1)) == Money::fromCents(19250000), "stock value of a small catalog");
+    catalog.insert(2, 1, "c", numeric_limits<int>::max(), Money::fromCents(1));
+    catalog.insert(2, 2, "d", 1, Money::fromCents(MAX_CENTS / 2));
+    check(catalog.stockValue(catalog.rangeOf(2)) == Money::fromCents(numeric_limits<int>::max() + MAX_CENTS / 2),
+          "stock value past the fast path's bound");
+    catalog.insert(3, 1, "e", 3, Money::fromCents(MAX_CENTS / 2));
+    check(throwsOverflow([&] { (void)catalog.stockValue(catalog.rangeOf(3)); }), "stock value out of range did not throw");
+
+    if (failures == 0) printf("Parsing, formatting and sums agree at the edges of the range\n");
+    return failures == 0 ? 0 : 3;
+}
@@ -0,0 +1,118 @@
+// Times placing and paying orders in the store against the layout orders
+// had before the arena: each order a value in a vector, paid by copying it
+// into the history and erasing it from the pending list.
+//   order_bench [orders] [linesPerOrder] [inFlight] [repeats]
+//
+// Both sides keep `inFlight` orders pending and pay the oldest as each new
+// one is placed, so the pending list stays the size a busy store would see.
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <deque>
+#include <string>
+#include <vector>
+#include "app_state.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+// The order layout before the arena.
+struct OldLine {
+    int itemId;
+    string name;
+    int quantity;
+    Money price;
+};
+struct OldOrder {
+    int id;
+    int buyerId;
+    string buyerName;
+    int sellerId;
+    string sellerName;
+    vector<OldLine> items;
+    Money total;
+    TransactionStatus status;
+    string date;
+};
+
+template <typename Fn>
+static double bestOf(int repeats, Fn fn) {
+    double best = 1e30;
+    for (int i = 0; i < repeats; i++) {
+        Clock::time_point start = Clock::now();
+        fn();
+        best = min(best, chrono::duration<double, milli>(Clock::now() - start).count());
+    }
+    return best;
+}
+
+int main(int argc, char *argv[]) {
+    int orders = argc > 1 ? atoi(argv[1]) : 1000000;
+    int lines = argc > 2 ? atoi(argv[2]) : 3;
+    int inFlight = argc > 3 ? atoi(argv[3]) : 64;
+    int repeats = argc > 4 ? atoi(argv[4]) : 3;
+    if (orders <= 0 || lines <= 0 || inFlight <= 0 || repeats <= 0) {
+        fprintf(stderr, "usage: %s [orders] [linesPerOrder] [inFlight] [repeats]\n", argv[0]);
+        return 1;
+    }
+
+    // Longer than the small-string buffer, as real names usually are
+    const string buyerName = "Buyer with a longer display name";
+    const string sellerName = "Storefront with a longer name";
+    const string itemName = "Item with a descriptive name";
+    const symbols::Id buyerNameId = symbols::intern(buyerName);
+    const symbols::Id sellerNameId = symbols::intern(sellerName);
+    const symbols::Id itemNameId = symbols::intern(itemName);
+    const Money price = Money::fromCents(1999);
+    const dt::Day today = dt::current_day();
+
+    size_t oldPaid = 0;
+    double oldMs = bestOf(repeats, [&] {
+        vector<OldOrder> pending, paid;
+        for (int n = 0; n < orders; n++) {
+            OldOrder o{n, n % 1000, buyerName, n % 100, sellerName, {}, Money(), PENDING, dt::format(today)};
+            for (int l = 0; l < lines; l++) {
+                o.items.push_back({l, itemName, 1, price});
+                o.total += price;
+            }
+            pending.push_back(o);
+            if (pending.size() > static_cast<size_t>(inFlight)) {
+                int id = n - inFlight;
+                auto it = find_if(pending.begin(), pending.end(), [id](const OldOrder &p) { return p.id == id; });
+                it->status = PAID;
+                paid.push_back(*it);
+                pending.erase(it);
+            }
+        }
+        oldPaid = paid.size();
+    });
+
+    size_t newPaid = 0;
+    double newMs = bestOf(repeats, [&] {
+        AppState state;
+        deque<int> open;
+        for (int n = 0; n < orders; n++) {
+            Transaction &o = state.createOrder(n % 1000, buyerNameId, n % 100, sellerNameId, today);
+            o.reserveItems(static_cast<size_t>(lines));
+            for (int l = 0; l < lines; l++) o.addItem(l, itemNameId, 1, price);
+            state.addPendingOrder(o);
+            open.push_back(o.getTransactionId());
+            if (open.size() > static_cast<size_t>(inFlight)) {
+                state.closeOrder(open.front(), PAID);
+                open.pop_front();
+            }
+        }
+        newPaid = state.transactions.size();
+    });
+
+    auto rate = [orders](double ms) { return orders / (ms / 1000.0); };
+    printf("--- %d orders x %d lines, %d in flight, best of %d ---\n", orders, lines, inFlight, repeats);
+    printf("Vector of orders, copy on pay : %9.1f ms  %12.0f orders/s\n", oldMs, rate(oldMs));
+    printf("Arena, relink on pay          : %9.1f ms  %12.0f orders/s\n", newMs, rate(newMs));
+    if (oldPaid != newPaid) {
+        printf("[X] Paid counts differ: %zu vs %zu\n", oldPaid, newPaid);
+        return 3;
+    }
+    return 0;
+}
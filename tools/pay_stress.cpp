@@ -0,0 +1,230 @@
+// Concurrent payment and top-up traffic against one AppState, checking that
+// no money or stock is created or lost.
+//   pay_stress [threads] [opsPerThread] [buyersPerThread] [hotBuyers]
+//
+// Each thread works on its own buyers and on a small set of hot buyers that
+// every thread shares, ordering from sellers that are themselves buyers, so
+// the same account is often payer in one thread and payee in another. The
+// journal compacts every 1000 records, so snapshots are written mid-traffic.
+// At the end:
+//   balances + paid to stores with no owner account == opening + top-ups
+//   the PAID history adds up to what the threads paid
+//   every item's stock + units sold == its opening stock, nothing reserved
+// and the journal, replayed into a fresh state, gives the same balances and
+// stock.
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <filesystem>
+#include <random>
+#include <string>
+#include <thread>
+#include <unistd.h>
+#include <unordered_map>
+#include <vector>
+#include "market.h"
+#include "persistence.h"
+
+using namespace std;
+using Clock = chrono::steady_clock;
+
+struct Store {
+    int sellerId;
+    vector<pair<int, Money>> items;  // item id, price
+};
+
+struct ThreadTotals {
+    int64_t toppedUp = 0;     // cents
+    int64_t paid = 0;         // cents
+    size_t payments = 0, topUps = 0, refused = 0, cancelled = 0;
+};
+
+static const int OPENING_STOCK = 1000000;
+
+static Money sumBalances(const AppState& state) {
+    Money sum;
+    for (const auto& acc : state.bankAccounts) sum += acc.getBalance();
+    return sum;
+}
+
+int main(int argc, char *argv[]) {
+    int threads = argc > 1 ? atoi(argv[1]) : static_cast<int>(max(2u, thread::hardware_concurrency()));
+    int ops = argc > 2 ? atoi(argv[2]) : 5000;
+    int perThread = argc > 3 ? atoi(argv[3]) : 16;
+    int hot = argc > 4 ? atoi(argv[4]) : 4;
+    if (threads <= 0 || ops <= 0 || perThread <= 0 || hot <= 0) {
+        fprintf(stderr, "usage: %s [threads] [opsPerThread] [buyersPerThread] [hotBuyers]\n", argv[0]);
+        return 1;
+    }
+
+    string dir = (filesystem::temp_directory_path() / ("pay_stress." + to_string(getpid()))).string();
+    filesystem::remove_all(dir);
+    int failures = 0;
+    {
+        AppState state;
+        store::Journal journal(dir);
+        journal.startBackground(chrono::milliseconds(5), store::Durability::WRITE);
+
+        // Buyers: per-thread ranges first, then the shared hot ones
+        mt19937_64 rng(7);
+        vector<int> buyerIds;
+        Money opening;
+        int total = threads * perThread + hot;
+        bool setup = true;
+        for (int i = 0; i < total; i++) {
+            int id;
+            setup &= market::registerBuyer(state, journal, "Buyer " + to_string(i), "b" + to_string(i) + "@example.com",
+                                           "0812" + to_string(i), "Street " + to_string(i), id) == market::OK;
+            Money deposit = Money::fromCents(static_cast<int64_t>(rng() % 50000));
+            setup &= market::openAccount(state, journal, id, deposit) == market::OK;
+            opening += deposit;
+            buyerIds.push_back(id);
+        }
+        // Stores: every hot buyer and the first buyer of each thread
+        vector<int> owners(buyerIds.end() - hot, buyerIds.end());
+        for (int t = 0; t < threads; t++) owners.push_back(buyerIds[static_cast<size_t>(t * perThread)]);
+        vector<Store> stores;
+        for (int owner : owners) {
+            Store s;
+            setup &= market::upgradeToSeller(state, journal, owner, "Store " + to_string(owner), s.sellerId) == market::OK;
+            for (int i = 1; i <= 5; i++) {
+                Money price = Money::fromCents(static_cast<int64_t>(100 + rng() % 5000));
+                setup &= market::addItem(state, journal, s.sellerId, i, "Item " + to_string(i), OPENING_STOCK, price) == market::OK;
+                s.items.emplace_back(i, price);
+            }
+            stores.push_back(s);
+        }
+        if (!setup) {
+            fprintf(stderr, "[X] Could not set up buyers and stores\n");
+            return 1;
+        }
+
+        vector<ThreadTotals> totals(static_cast<size_t>(threads));
+        atomic<bool> go{false};
+        vector<thread> workers;
+        for (int t = 0; t < threads; t++) {
+            workers.emplace_back([&, t] {
+                mt19937_64 r(static_cast<uint64_t>(t) + 100);
+                ThreadTotals& mine = totals[static_cast<size_t>(t)];
+                while (!go.load()) this_thread::yield();
+                for (int n = 0; n < ops; n++) {
+                    int buyer = r() % 2 ? buyerIds[static_cast<size_t>(t * perThread) + r() % static_cast<size_t>(perThread)]
+                                        : buyerIds[buyerIds.size() - 1 - r() % static_cast<size_t>(hot)];
+                    if (r() % 4 == 0) {
+                        Money amount = Money::fromCents(static_cast<int64_t>(1 + r() % 3000));
+                        if (market::topUp(state, journal, buyer, amount) == market::OK) {
+                            mine.toppedUp += amount.cents();
+                            mine.topUps++;
+                        }
+                        continue;
+                    }
+                    const Store& s = stores[r() % stores.size()];
+                    vector<market::OrderLine> lines;
+                    Money orderTotal;
+                    for (size_t l = 0, count = 1 + r() % 3; l < count; l++) {
+                        const auto& [itemId, price] = s.items[l];
+                        int qty = static_cast<int>(1 + r() % 3);
+                        lines.push_back({itemId, qty});
+                        orderTotal += price * qty;
+                    }
+                    int txn;
+                    if (market::placeOrder(state, journal, buyer, s.sellerId, lines, txn) != market::OK) {
+                        mine.refused++;
+                        continue;
+                    }
+                    Money balance;
+                    if (market::payOrder(state, journal, buyer, txn, balance) == market::OK) {
+                        mine.paid += orderTotal.cents();
+                        mine.payments++;
+                    } else if (market::cancelOrder(state, journal, buyer, txn) == market::OK) {
+                        mine.cancelled++;
+                    }
+                }
+            });
+        }
+        Clock::time_point start = Clock::now();
+        go.store(true);
+        for (auto& w : workers) w.join();
+        double seconds = chrono::duration<double>(Clock::now() - start).count();
+        journal.flush();
+
+        ThreadTotals sum;
+        for (const auto& t : totals) {
+            sum.toppedUp += t.toppedUp;
+            sum.paid += t.paid;
+            sum.payments += t.payments;
+            sum.topUps += t.topUps;
+            sum.refused += t.refused;
+            sum.cancelled += t.cancelled;
+        }
+        printf("--- %d threads x %d ops in %.2f s: %zu payments, %zu top-ups, %zu cancelled, %zu refused ---\n",
+               threads, ops, seconds, sum.payments, sum.topUps, sum.cancelled, sum.refused);
+
+        // What went to stores whose owner has no account, and units sold
+        Money paidHistory, leftSystem;
+        unordered_map<int64_t, int> sold;  // sellerId << 32 | itemId
+        for (const auto& order : state.transactions) {
+            if (order.getStatus() != PAID) continue;
+            paidHistory += order.getTotalAmount();
+            seller* s = state.findSeller(order.getSellerId());
+            if (!s || !state.accountOf(*state.ownerOf(*s))) leftSystem += order.getTotalAmount();
+            for (const auto& line : order.getItems()) {
+                sold[static_cast<int64_t>(order.getSellerId()) << 32 | line.getItemId()] += line.getQuantity();
+            }
+        }
+
+        Money balances = sumBalances(state);
+        Money expected = opening + Money::fromCents(sum.toppedUp);
+        if (balances + leftSystem != expected) {
+            printf("[X] Balances %s + paid out %s != opening %s + top-ups %s\n", balances.toString().c_str(),
+                   leftSystem.toString().c_str(), opening.toString().c_str(), Money::fromCents(sum.toppedUp).toString().c_str());
+            failures++;
+        }
+        if (paidHistory != Money::fromCents(sum.paid)) {
+            printf("[X] PAID orders total %s, threads paid %s\n", paidHistory.toString().c_str(),
+                   Money::fromCents(sum.paid).toString().c_str());
+            failures++;
+        }
+        for (const Store& s : stores) {
+            for (const auto& item : state.items(s.sellerId)) {
+                int units = sold[static_cast<int64_t>(s.sellerId) << 32 | item.getId()];
+                if (item.getQuantity() + units != OPENING_STOCK || item.getReserved() != 0) {
+                    printf("[X] Store %d item %d: stock %d + sold %d, reserved %d\n", s.sellerId, item.getId(),
+                           item.getQuantity(), units, item.getReserved());
+                    failures++;
+                }
+            }
+        }
+
+        // The journal (and any compaction on the way) must tell the same story
+        AppState replayed;
+        store::load_all(replayed, dir);
+        for (const auto& acc : state.bankAccounts) {
+            const BankCustomer* again = replayed.findAccount(acc.getId());
+            if (!again || again->getBalance() != acc.getBalance()) {
+                printf("[X] Account %d is %s after replay, %s in memory\n", acc.getId(),
+                       again ? again->getBalance().toString().c_str() : "missing", acc.getBalance().toString().c_str());
+                failures++;
+            }
+        }
+        for (const Store& s : stores) {
+            for (const auto& item : state.items(s.sellerId)) {
+                Item again = replayed.findItem(s.sellerId, item.getId());
+                if (!again || again.getQuantity() != item.getQuantity() || again.getReserved() != item.getReserved()) {
+                    printf("[X] Store %d item %d: stock %d, reserved %d after replay, %d, %d in memory\n", s.sellerId,
+                           item.getId(), again ? again.getQuantity() : -1, again ? again.getReserved() : -1,
+                           item.getQuantity(), item.getReserved());
+                    failures++;
+                }
+            }
+        }
+        if (failures == 0) {
+            printf("Balances conserved: %s + %s paid out = %s opening + %s topped up; replay agrees\n",
+                   balances.toString().c_str(), leftSystem.toString().c_str(), opening.toString().c_str(),
+                   Money::fromCents(sum.toppedUp).toString().c_str());
+        }
+    }
+    filesystem::remove_all(dir);
+    return failures == 0 ? 0 : 3;
+}